@@ -0,0 +1,55 @@
+#pragma once
+
+// Генератор входного документа для бенчмарков разбора: base_requests в формате входа
+// (остановки с road_distances и автобусы), отформатированные с отступами, как файлы базы
+#include <cstddef>
+#include <random>
+#include <string>
+
+namespace benchmark
+{
+    inline std::string MakeStopName(size_t index)
+    {
+        return "Stop " + std::to_string(index);
+    }
+
+    // Документ не меньше target_size байт: на каждые четыре остановки приходится автобус
+    inline std::string MakeBaseDocument(size_t target_size, unsigned seed = 42)
+    {
+        std::mt19937 random(seed);
+        std::string text;
+        text.reserve(target_size + 4096);
+        text += "{\n  \"base_requests\": [\n";
+        for (size_t stop = 0; text.size() < target_size; ++stop)
+        {
+            if (stop > 0)
+            {
+                text += ",\n";
+            }
+            text += "    {\n      \"type\": \"Stop\",\n      \"name\": \"" + MakeStopName(stop) + "\",\n";
+            text += "      \"latitude\": " + std::to_string(55.5 + random() % 100000 / 200000.0) + ",\n";
+            text += "      \"longitude\": " + std::to_string(37.3 + random() % 100000 / 200000.0) + ",\n";
+            text += "      \"road_distances\": {";
+            for (size_t i = 0, count = random() % 4 + 1; i < count; ++i)
+            {
+                text += (i > 0 ? ", \"" : "\"") + MakeStopName(stop + i + 1) + "\": " + std::to_string(300 + random() % 5000);
+            }
+            text += "}\n    }";
+
+            if (stop % 4 == 3)
+            {
+                text += ",\n    {\n      \"type\": \"Bus\",\n      \"name\": \"" + std::to_string(stop / 4) + "\",\n";
+                text += "      \"stops\": [";
+                for (size_t i = 0, count = random() % 16 + 5; i < count; ++i)
+                {
+                    text += (i > 0 ? ", \"" : "\"") + MakeStopName(random() % (stop + 1)) + "\"";
+                }
+                text += "],\n      \"is_roundtrip\": ";
+                text += random() % 2 ? "true" : "false";
+                text += "\n    }";
+            }
+        }
+        text += "\n  ]\n}\n";
+        return text;
+    }
+}
@@ -0,0 +1,186 @@
+// Двунаправленный поиск против одиночного поиска Дейкстры на синтетических сетях.
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -I. benchmarks/bidirectional_dijkstra_benchmark.cpp
+//       -o bidirectional_dijkstra_benchmark
+// Аргументы: числа остановок (1000 10000 50000); число пар задаёт PAIR_COUNT
+#include "../bidirectional_dijkstra.h"
+#include "../dijkstra.h"
+#include "../graph.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using Weight = std::int32_t;
+    using Graph = graph::DirectedWeightedGraph<Weight>;
+
+    constexpr size_t PAIR_COUNT = 300;
+    constexpr size_t STOPS_PER_BUS = 12;
+    constexpr Weight WAIT_WEIGHT = 36000;
+
+    double ElapsedUs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+
+    // Граф в раскладке TransportRouter: у остановки k вершина прибытия 2k и вершина
+    // после ожидания 2k + 1. Остановки стоят в узлах квадратной сетки, автобус идёт
+    // по соседним узлам и соединяет каждую пару своих остановок ребром
+    Graph MakeNetwork(size_t stop_count, std::mt19937& random)
+    {
+        const size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(stop_count))));
+        Graph network(stop_count * 2);
+        for (size_t stop = 0; stop < stop_count; ++stop)
+        {
+            network.AddEdge({ "", 0, stop * 2, stop * 2 + 1, WAIT_WEIGHT });
+        }
+
+        // Линии вдоль рядов и столбцов сетки связывают сеть, случайные маршруты по соседним
+        // узлам добавляют пересадки; всего через остановку в среднем проходит четыре автобуса
+        std::vector<std::vector<size_t>> buses;
+        for (size_t line = 0; line < side; ++line)
+        {
+            for (size_t begin = 0; begin + 1 < side; begin += STOPS_PER_BUS - 1)
+            {
+                std::vector<size_t> row;
+                std::vector<size_t> column;
+                for (size_t i = begin; i < side && i < begin + STOPS_PER_BUS; ++i)
+                {
+                    if (line * side + i < stop_count)
+                    {
+                        row.push_back(line * side + i);
+                    }
+                    if (i * side + line < stop_count)
+                    {
+                        column.push_back(i * side + line);
+                    }
+                }
+                buses.push_back(std::move(row));
+                buses.push_back(std::move(column));
+            }
+        }
+        for (size_t bus = 0; bus < stop_count * 2 / STOPS_PER_BUS; ++bus)
+        {
+            std::vector<size_t> stops = { random() % stop_count };
+            while (stops.size() < STOPS_PER_BUS)
+            {
+                const size_t row = stops.back() / side;
+                const size_t column = stops.back() % side;
+                size_t next = stops.back();
+                switch (random() % 4)
+                {
+                case 0:
+                    next = row > 0 ? next - side : next;
+                    break;
+                case 1:
+                    next = next + side < stop_count ? next + side : next;
+                    break;
+                case 2:
+                    next = column > 0 ? next - 1 : next;
+                    break;
+                default:
+                    next = column + 1 < side && next + 1 < stop_count ? next + 1 : next;
+                    break;
+                }
+                if (next != stops.back())
+                {
+                    stops.push_back(next);
+                }
+            }
+            buses.push_back(std::move(stops));
+        }
+
+        // Автобус некольцевой: идёт по маршруту в обе стороны
+        for (const auto& stops : buses)
+        {
+            std::vector<Weight> legs;
+            for (size_t i = 1; i < stops.size(); ++i)
+            {
+                legs.push_back(static_cast<Weight>(30000 + random() % 150000));
+            }
+            for (size_t from = 0; from < stops.size(); ++from)
+            {
+                Weight weight = 0;
+                for (size_t to = from + 1; to < stops.size(); ++to)
+                {
+                    weight += legs[to - 1];
+                    network.AddEdge({ "", to - from, stops[from] * 2 + 1, stops[to] * 2, weight });
+                    network.AddEdge({ "", to - from, stops[to] * 2 + 1, stops[from] * 2, weight });
+                }
+            }
+        }
+        return network;
+    }
+
+    // Возвращает число пар, на которых веса двух поисков разошлись
+    size_t RunBenchmark(size_t stop_count, std::mt19937& random)
+    {
+        const Graph network = MakeNetwork(stop_count, random);
+        std::vector<std::pair<graph::VertexId, graph::VertexId>> pairs;
+        for (size_t i = 0; i < PAIR_COUNT; ++i)
+        {
+            pairs.push_back({ random() % stop_count * 2, random() % stop_count * 2 });
+        }
+
+        graph::Dijkstra<Weight> dijkstra(network);
+        std::vector<std::optional<Weight>> expected;
+        const auto dijkstra_start = Clock::now();
+        for (const auto& [from, to] : pairs)
+        {
+            dijkstra.Run(from, to);
+            expected.push_back(dijkstra.IsReached(to) ? std::optional<Weight>(dijkstra.GetWeight(to)) : std::nullopt);
+        }
+        const double dijkstra_us = ElapsedUs(dijkstra_start) / PAIR_COUNT;
+
+        graph::BidirectionalDijkstra<Weight> bidirectional(network);
+        std::vector<std::optional<Weight>> found;
+        const auto bidirectional_start = Clock::now();
+        for (const auto& [from, to] : pairs)
+        {
+            found.push_back(bidirectional.ForEachRouteEdge(from, to, [](graph::EdgeId) {}));
+        }
+        const double bidirectional_us = ElapsedUs(bidirectional_start) / PAIR_COUNT;
+
+        size_t mismatches = 0;
+        size_t reachable_count = 0;
+        for (size_t i = 0; i < PAIR_COUNT; ++i)
+        {
+            mismatches += expected[i] != found[i] ? 1 : 0;
+            reachable_count += expected[i] ? 1 : 0;
+        }
+        std::cout << stop_count << " stops, " << network.GetEdgeCount() << " edges, " << reachable_count << " of "
+            << PAIR_COUNT << " pairs reachable: dijkstra " << dijkstra_us
+            << " us, bidirectional " << bidirectional_us << " us per query, mismatched weights: " << mismatches << '\n';
+        return mismatches;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<size_t> stop_counts;
+    for (int i = 1; i < argc; ++i)
+    {
+        stop_counts.push_back(std::atoi(argv[i]));
+    }
+    if (stop_counts.empty())
+    {
+        stop_counts = { 1000, 10000, 50000 };
+    }
+
+    std::mt19937 random(42);
+    size_t mismatches = 0;
+    for (const size_t stop_count : stop_counts)
+    {
+        mismatches += RunBenchmark(stop_count, random);
+    }
+    std::cout.flush();
+    return mismatches == 0 ? 0 : 1;
+}
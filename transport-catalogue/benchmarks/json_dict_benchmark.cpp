@@ -0,0 +1,109 @@
+// json::Dict на сгенерированном документе базы: разбор, проход с теми обращениями по ключам,
+// что делает ProcessBaseRequests, и пиковая память после разбора.
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -I. benchmarks/json_dict_benchmark.cpp json.cpp json_arena.cpp
+//       -o json_dict_benchmark
+// Бенчмарк пользуется только Load(std::istream&), at, AsMap и AsArray, поэтому собирается
+// и с json.cpp времён Dict на std::map (без файлов, которых там ещё нет).
+// Аргументы: размер документа в мегабайтах (100), число проходов по ключам (3)
+#include "../json.h"
+#include "base_document.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double ElapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Сумма нужна, чтобы компилятор не выбросил обращения
+    size_t LookUpBaseRequests(const json::Array& base_requests)
+    {
+        size_t sum = 0;
+        for (const auto& request : base_requests)
+        {
+            const auto& request_map = request.AsMap();
+            const std::string& type = request_map.at("type").AsString();
+            sum += request_map.at("name").AsString().size();
+            if (type == "Stop")
+            {
+                sum += static_cast<size_t>(request_map.at("latitude").AsDouble() + request_map.at("longitude").AsDouble());
+                for (const auto& [stop_name, distance] : request_map.at("road_distances").AsMap())
+                {
+                    sum += stop_name.size() + distance.AsInt();
+                }
+            }
+            else if (type == "Bus")
+            {
+                for (const auto& stop : request_map.at("stops").AsArray())
+                {
+                    sum += stop.AsString().size();
+                }
+                sum += request_map.at("is_roundtrip").AsBool() ? 1 : 0;
+            }
+        }
+        return sum;
+    }
+
+    long GetMaxRssKb()
+    {
+#if defined(_WIN32)
+        return 0;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+#endif
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t size_mb = argc > 1 ? std::atoi(argv[1]) : 100;
+    const size_t pass_count = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    json::Document document{ json::Node() };
+    double parse_ms = 0.0;
+    double text_mb = 0.0;
+    long text_rss_kb = 0;
+    {
+        const std::string text = benchmark::MakeBaseDocument(size_mb * 1024 * 1024);
+        text_mb = text.size() / (1024.0 * 1024.0);
+        text_rss_kb = GetMaxRssKb();
+        std::istringstream input(text);
+        const auto start = Clock::now();
+        document = json::Load(input);
+        parse_ms = ElapsedMs(start);
+    }
+    const long document_rss_kb = GetMaxRssKb();
+
+    const auto& base_requests = document.GetRoot().AsMap().at("base_requests").AsArray();
+    double best_lookup_ms = 0.0;
+    size_t sum = 0;
+    for (size_t pass = 0; pass < pass_count; ++pass)
+    {
+        const auto start = Clock::now();
+        sum += LookUpBaseRequests(base_requests);
+        const double lookup_ms = ElapsedMs(start);
+        best_lookup_ms = pass == 0 || lookup_ms < best_lookup_ms ? lookup_ms : best_lookup_ms;
+    }
+
+    std::cout << "document: " << text_mb << " MB, " << base_requests.size() << " base requests\n"
+        << "parse: " << parse_ms << " ms, " << text_mb * 1000.0 / parse_ms << " MB/s\n"
+        << "lookup pass: " << best_lookup_ms << " ms best of " << pass_count << " (sum " << sum << ")\n"
+        << "peak RSS: " << document_rss_kb / 1024 << " MB through Load, " << text_rss_kb / 1024 << " MB with the text alone"
+        << std::endl;
+    return 0;
+}
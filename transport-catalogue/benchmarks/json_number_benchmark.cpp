@@ -0,0 +1,99 @@
+// Разбор и вывод документа, состоящего в основном из чисел: массив объектов с двумя
+// координатами в 15-17 значащих цифр, целым и дробным полем.
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -I. benchmarks/json_number_benchmark.cpp json.cpp json_arena.cpp
+//       -o json_number_benchmark
+// Бенчмарк пользуется только Load(std::istream&) и Print(doc, std::ostream&), поэтому
+// собирается и с json.cpp времён std::stod и вывода через поток (без файлов, которых там ещё нет).
+// Возвращает 1, если выведенный документ после повторного разбора расходится с исходным
+// в целых числах или числе объектов.
+// Аргументы: число объектов (1000000), число прогонов (3)
+#include "../json.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double ElapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    std::string MakeNumberDocument(size_t object_count)
+    {
+        std::mt19937_64 random(42);
+        std::uniform_real_distribution<double> offset(0.0, 1.0);
+        std::string text = "[";
+        char buffer[128];
+        for (size_t i = 0; i < object_count; ++i)
+        {
+            const int precision = 15 + static_cast<int>(random() % 3);
+            std::snprintf(buffer, sizeof(buffer), "%s{\"latitude\": %.*g, \"longitude\": %.*g, \"id\": %d, \"value\": %.6g}",
+                i > 0 ? ",\n" : "", precision, 55.0 + offset(random), precision, 37.0 + offset(random),
+                static_cast<int>(random() % 100000000), offset(random) * 10000.0);
+            text += buffer;
+        }
+        text += "]\n";
+        return text;
+    }
+
+    // Сумма целых полей: вывод целых не теряет точности, так что она переживает повторный разбор
+    long long SumIds(const json::Document& document)
+    {
+        long long sum = 0;
+        for (const auto& item : document.GetRoot().AsArray())
+        {
+            sum += item.AsMap().at("id").AsInt();
+        }
+        return sum;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t object_count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    const size_t run_count = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    const std::string text = MakeNumberDocument(object_count);
+    const double text_mb = text.size() / (1024.0 * 1024.0);
+
+    double best_load_ms = 0.0;
+    double best_print_ms = 0.0;
+    std::string printed;
+    json::Document document{ json::Node() };
+    for (size_t run = 0; run < run_count; ++run)
+    {
+        std::istringstream input(text);
+        const auto load_start = Clock::now();
+        document = json::Load(input);
+        const double load_ms = ElapsedMs(load_start);
+        best_load_ms = run == 0 || load_ms < best_load_ms ? load_ms : best_load_ms;
+
+        std::ostringstream output;
+        const auto print_start = Clock::now();
+        json::Print(document, output);
+        const double print_ms = ElapsedMs(print_start);
+        best_print_ms = run == 0 || print_ms < best_print_ms ? print_ms : best_print_ms;
+        printed = output.str();
+    }
+
+    std::istringstream reloaded_input(printed);
+    const json::Document reloaded = json::Load(reloaded_input);
+    const bool is_same = reloaded.GetRoot().AsArray().size() == document.GetRoot().AsArray().size()
+        && SumIds(reloaded) == SumIds(document);
+
+    std::cout << "document: " << text_mb << " MB, " << object_count << " objects\n"
+        << "Load: " << best_load_ms << " ms, " << text_mb * 1000.0 / best_load_ms << " MB/s best of " << run_count << '\n'
+        << "Print: " << best_print_ms << " ms best of " << run_count << ", " << printed.size() / (1024.0 * 1024.0)
+        << " MB\n"
+        << "reloaded output " << (is_same ? "matches" : "DIFFERS") << std::endl;
+    return is_same ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+// Скорость json::Load(std::istream&) на сгенерированном документе базы.
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -I. benchmarks/json_parse_benchmark.cpp json.cpp json_arena.cpp
+//       -o json_parse_benchmark
+// Бенчмарк пользуется только Load(std::istream&), поэтому собирается и с json.cpp прежних версий
+// (без файлов, которых в них ещё нет) — так сравнивается разбор до и после изменения.
+// Аргументы: размер документа в мегабайтах (100), число прогонов (3)
+#include "../json.h"
+#include "base_document.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double ElapsedSeconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t size_mb = argc > 1 ? std::atoi(argv[1]) : 100;
+    const size_t run_count = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    const std::string text = benchmark::MakeBaseDocument(size_mb * 1024 * 1024);
+    const double text_mb = text.size() / (1024.0 * 1024.0);
+
+    double total_seconds = 0.0;
+    double best_seconds = 0.0;
+    size_t request_count = 0;
+    for (size_t run = 0; run < run_count; ++run)
+    {
+        std::istringstream input(text);
+        const auto start = Clock::now();
+        const json::Document document = json::Load(input);
+        const double seconds = ElapsedSeconds(start);
+        request_count = document.GetRoot().AsMap().at("base_requests").AsArray().size();
+        total_seconds += seconds;
+        best_seconds = run == 0 || seconds < best_seconds ? seconds : best_seconds;
+    }
+
+    std::cout << "document: " << text_mb << " MB, " << request_count << " base requests\n"
+        << "Load(std::istream&): " << text_mb * run_count / total_seconds << " MB/s mean, "
+        << text_mb / best_seconds << " MB/s best of " << run_count << std::endl;
+    return 0;
+}
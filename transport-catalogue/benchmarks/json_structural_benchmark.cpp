@@ -0,0 +1,102 @@
+// Разбор документа, уже лежащего в памяти, с каждым вариантом классификации блоков
+// структурного индекса. Вариант выбирается флагами сборки из каталога transport-catalogue:
+//   AVX2:   g++ -std=c++17 -O2 -mavx2 -I. benchmarks/json_structural_benchmark.cpp json.cpp json_arena.cpp
+//   SSE2:   g++ -std=c++17 -O2 -I. benchmarks/json_structural_benchmark.cpp json.cpp json_arena.cpp
+//   скаляр: g++ -std=c++17 -O2 -DJSON_STRUCTURAL_SCALAR -I. benchmarks/json_structural_benchmark.cpp
+//           json.cpp json_arena.cpp
+// Контрольная сумма документа у всех вариантов должна совпадать.
+// Аргументы: размер документа в мегабайтах (100), число прогонов (3)
+#include "../json.h"
+#include "base_document.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double ElapsedSeconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Тот же выбор, что в json.cpp
+    const char* GetVariantName()
+    {
+#if defined(JSON_STRUCTURAL_SCALAR)
+        return "scalar";
+#elif defined(__AVX2__)
+        return "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        return "SSE2";
+#else
+        return "scalar";
+#endif
+    }
+
+    // Сумма по всем узлам, зависящая от типов, чисел, строк и ключей
+    size_t Checksum(const json::Node& node)
+    {
+        size_t sum = 1;
+        if (node.IsArray())
+        {
+            for (const auto& item : node.AsArray())
+            {
+                sum = sum * 31 + Checksum(item);
+            }
+        }
+        else if (node.IsMap())
+        {
+            for (const auto& [key, value] : node.AsMap())
+            {
+                sum = sum * 31 + std::hash<std::string>{}(key) + Checksum(value);
+            }
+        }
+        else if (node.IsString())
+        {
+            sum += std::hash<std::string>{}(node.AsString());
+        }
+        else if (node.IsInt())
+        {
+            sum += static_cast<size_t>(node.AsInt());
+        }
+        else if (node.IsDouble())
+        {
+            sum += std::hash<double>{}(node.AsDouble());
+        }
+        return sum;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t size_mb = argc > 1 ? std::atoi(argv[1]) : 100;
+    const size_t run_count = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    const std::string text = benchmark::MakeBaseDocument(size_mb * 1024 * 1024);
+    const double text_mb = text.size() / (1024.0 * 1024.0);
+
+    double total_seconds = 0.0;
+    double best_seconds = 0.0;
+    size_t checksum = 0;
+    for (size_t run = 0; run < run_count; ++run)
+    {
+        const auto start = Clock::now();
+        const json::Document document = json::Load(std::string_view(text));
+        const double seconds = ElapsedSeconds(start);
+        checksum = Checksum(document.GetRoot());
+        total_seconds += seconds;
+        best_seconds = run == 0 || seconds < best_seconds ? seconds : best_seconds;
+    }
+
+    std::cout << GetVariantName() << ", document: " << text_mb << " MB\n"
+        << "Load(std::string_view): " << text_mb * run_count / total_seconds << " MB/s mean, "
+        << text_mb / best_seconds << " MB/s best of " << run_count << '\n'
+        << "checksum: " << checksum << std::endl;
+    return 0;
+}
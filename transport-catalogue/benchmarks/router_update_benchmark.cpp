@@ -0,0 +1,132 @@
+// Инкрементальное обновление роутера против полной пересборки на синтетической сети.
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -pthread -I. benchmarks/router_update_benchmark.cpp
+//       transport_catalogue.cpp transport_router.cpp -o router_update_benchmark
+// Аргументы: число остановок (400), число автобусов (60), остановок на автобус (12)
+#include "../transport_catalogue.h"
+#include "../transport_router.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double ElapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    std::vector<std::string_view> RandomStops(const std::vector<std::string>& stop_names, size_t count, std::mt19937& random)
+    {
+        std::vector<std::string_view> stops;
+        for (size_t i = 0; i < count; ++i)
+        {
+            stops.push_back(stop_names[random() % stop_names.size()]);
+        }
+        return stops;
+    }
+
+    // Число пар остановок, на которых маршруты двух роутеров расходятся по времени
+    size_t CountMismatches(const TransportRouter& lhs, const TransportRouter& rhs, const std::vector<std::string>& stop_names)
+    {
+        size_t mismatches = 0;
+        for (size_t i = 0; i < stop_names.size(); i += 7)
+        {
+            for (size_t j = 0; j < stop_names.size(); j += 5)
+            {
+                const auto lhs_route = lhs.FindRoute(stop_names[i], stop_names[j]);
+                const auto rhs_route = rhs.FindRoute(stop_names[i], stop_names[j]);
+                if (lhs_route.has_value() != rhs_route.has_value()
+                    || (lhs_route && std::abs(lhs_route->total_time - rhs_route->total_time) > 1e-9))
+                {
+                    ++mismatches;
+                }
+            }
+        }
+        return mismatches;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t stop_count = argc > 1 ? std::atoi(argv[1]) : 400;
+    const size_t bus_count = argc > 2 ? std::atoi(argv[2]) : 60;
+    const size_t stops_per_bus = argc > 3 ? std::atoi(argv[3]) : 12;
+    constexpr int BUS_WAIT_TIME = 6;
+    constexpr double BUS_VELOCITY = 40.0;
+    constexpr size_t UPDATE_COUNT = 20;
+
+    std::mt19937 random(42);
+    TransportCatalogue catalogue;
+    std::vector<std::string> stop_names;
+    for (size_t i = 0; i < stop_count; ++i)
+    {
+        stop_names.push_back("S" + std::to_string(i));
+        catalogue.AddStop(stop_names.back(), { 55.5 + (random() % 1000) / 2000.0, 37.3 + (random() % 1000) / 2000.0 });
+    }
+    for (size_t i = 0; i < stop_count; ++i)
+    {
+        catalogue.AddDistance(catalogue.FindStop(stop_names[i]), catalogue.FindStop(stop_names[(i + 1) % stop_count]),
+            500 + random() % 3000);
+    }
+    std::vector<std::string> bus_names;
+    for (size_t i = 0; i < bus_count; ++i)
+    {
+        bus_names.push_back("B" + std::to_string(i));
+        catalogue.AddBus(bus_names.back(), RandomStops(stop_names, stops_per_bus, random), true);
+    }
+
+    RouterOptions options;
+    options.backend = RouterBackend::AllPairs;
+    TransportRouter router(catalogue, BUS_WAIT_TIME, BUS_VELOCITY, options);
+
+    // Чередуются добавление нового автобуса, замена существующего и удаление
+    constexpr const char* UPDATE_KINDS[] = { "add", "replace", "remove" };
+    double update_ms[3] = {};
+    size_t update_counts[3] = {};
+    double rebuild_ms = 0.0;
+    size_t mismatches = 0;
+    for (size_t step = 0; step < UPDATE_COUNT; ++step)
+    {
+        std::string bus_name;
+        if (step % 3 == 2)
+        {
+            bus_name = bus_names[random() % bus_names.size()];
+            catalogue.RemoveBus(bus_name);
+        }
+        else
+        {
+            bus_name = step % 3 == 0 ? "N" + std::to_string(step) : bus_names[random() % bus_names.size()];
+            catalogue.RemoveBus(bus_name);
+            catalogue.AddBus(bus_name, RandomStops(stop_names, stops_per_bus, random), true);
+        }
+
+        const auto update_start = Clock::now();
+        router.Update({ bus_name });
+        update_ms[step % 3] += ElapsedMs(update_start);
+        ++update_counts[step % 3];
+
+        const auto rebuild_start = Clock::now();
+        const TransportRouter rebuilt_router(catalogue, BUS_WAIT_TIME, BUS_VELOCITY, options);
+        rebuild_ms += ElapsedMs(rebuild_start);
+
+        mismatches += CountMismatches(router, rebuilt_router, stop_names);
+    }
+
+    std::cout << "stops: " << stop_count << ", buses: " << bus_count << ", stops per bus: " << stops_per_bus << '\n';
+    for (size_t kind = 0; kind < 3; ++kind)
+    {
+        std::cout << "incremental " << UPDATE_KINDS[kind] << ": " << update_ms[kind] / update_counts[kind] << " ms per bus\n";
+    }
+    std::cout << "full rebuild: " << rebuild_ms / UPDATE_COUNT << " ms per bus\n"
+        << "mismatched routes: " << mismatches << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+	// Поиск кратчайшего пути между парой вершин одновременно от начала по исходящим рёбрам
+	// и от конца по входящим. Поиски встречаются посередине, и каждый обходит область
+	// примерно вдвое меньшего радиуса, чем одиночный поиск Дейкстры.
+	// Состояние переиспользуется между запусками, как в Dijkstra
+	template <typename Weight>
+	class BidirectionalDijkstra {
+	private:
+		using Graph = DirectedWeightedGraph<Weight>;
+
+	public:
+		// Поиск идёт по весам профиля profile
+		explicit BidirectionalDijkstra(const Graph& graph, ProfileId profile = 0);
+
+		// Тот же результат, что у Router::BuildRoute
+		std::optional<typename Router<Weight>::RouteInfo> BuildRoute(VertexId from, VertexId to);
+
+		// Передаёт рёбра маршрута посетителю в порядке следования.
+		// Возвращает вес маршрута или nullopt, если маршрута нет
+		template <typename EdgeVisitor>
+		std::optional<Weight> ForEachRouteEdge(VertexId from, VertexId to, EdgeVisitor&& visitor);
+
+	private:
+		// Для прямого поиска edge — последнее ребро пути от начала,
+		// для обратного — первое ребро пути до конца
+		struct VertexState {
+			Weight weight{};
+			std::optional<EdgeId> edge;
+			size_t run = 0;
+		};
+		using QueueItem = std::pair<Weight, VertexId>;
+
+		struct Direction {
+			std::vector<VertexState> states;
+			std::vector<QueueItem> queue;
+		};
+
+		// Извлекает вершину из очереди направления и релаксирует её рёбра.
+		// is_forward выбирает исходящие или входящие рёбра
+		void Step(Direction& direction, const Direction& opposite, bool is_forward);
+		void UpdateMeeting(VertexId vertex);
+		std::optional<Weight> GetQueueMinimum(Direction& direction) const;
+
+		static constexpr Weight ZERO_WEIGHT{};
+		static constexpr Weight UNREACHABLE = UnreachableWeight<Weight>();
+		const Graph& graph_;
+		ProfileId profile_;
+		Direction forward_;
+		Direction backward_;
+		size_t run_ = 0;
+		std::optional<Weight> best_weight_;
+		VertexId meeting_vertex_ = 0;
+	};
+
+	template <typename Weight>
+	BidirectionalDijkstra<Weight>::BidirectionalDijkstra(const Graph& graph, ProfileId profile)
+		: graph_(graph)
+		, profile_(profile)
+		, forward_{ std::vector<VertexState>(graph.GetVertexCount()), {} }
+		, backward_{ std::vector<VertexState>(graph.GetVertexCount()), {} }
+	{
+	}
+
+	template <typename Weight>
+	std::optional<Weight> BidirectionalDijkstra<Weight>::GetQueueMinimum(Direction& direction) const {
+		// Устаревшие записи очереди отбрасываются, чтобы условие остановки было точным
+		while (!direction.queue.empty()) {
+			const auto [weight, vertex] = direction.queue.front();
+			if (!(direction.states[vertex].weight < weight)) {
+				return weight;
+			}
+			std::pop_heap(direction.queue.begin(), direction.queue.end(), std::greater<QueueItem>{});
+			direction.queue.pop_back();
+		}
+		return std::nullopt;
+	}
+
+	template <typename Weight>
+	void BidirectionalDijkstra<Weight>::UpdateMeeting(VertexId vertex) {
+		const auto& forward_state = forward_.states[vertex];
+		const auto& backward_state = backward_.states[vertex];
+		if (forward_state.run != run_ || backward_state.run != run_) {
+			return;
+		}
+		const Weight weight = AddWeights(forward_state.weight, backward_state.weight);
+		if (weight < UNREACHABLE && (!best_weight_ || weight < *best_weight_)) {
+			best_weight_ = weight;
+			meeting_vertex_ = vertex;
+		}
+	}
+
+	template <typename Weight>
+	void BidirectionalDijkstra<Weight>::Step(Direction& direction, const Direction& opposite, bool is_forward) {
+		std::pop_heap(direction.queue.begin(), direction.queue.end(), std::greater<QueueItem>{});
+		const auto [weight, vertex] = direction.queue.back();
+		direction.queue.pop_back();
+
+		const auto edges = is_forward ? graph_.GetIncidentEdges(vertex) : graph_.GetIncomingEdges(vertex);
+		for (const EdgeId edge_id : edges) {
+			const auto& edge = graph_.GetEdge(edge_id);
+			const Weight edge_weight = graph_.GetEdgeWeight(edge_id, profile_);
+			if (edge_weight < ZERO_WEIGHT) {
+				throw std::domain_error("Edges' weights should be non-negative");
+			}
+			const VertexId next = is_forward ? edge.to : edge.from;
+			// Путь, чей вес не помещается в тип, считается непроходимым
+			const Weight candidate_weight = AddWeights(weight, edge_weight);
+			if (!(candidate_weight < UNREACHABLE)) {
+				continue;
+			}
+			auto& state = direction.states[next];
+			if (state.run != run_ || candidate_weight < state.weight) {
+				state = VertexState{ candidate_weight, edge_id, run_ };
+				direction.queue.push_back({ candidate_weight, next });
+				std::push_heap(direction.queue.begin(), direction.queue.end(), std::greater<QueueItem>{});
+				if (opposite.states[next].run == run_) {
+					UpdateMeeting(next);
+				}
+			}
+		}
+	}
+
+	template <typename Weight>
+	template <typename EdgeVisitor>
+	std::optional<Weight> BidirectionalDijkstra<Weight>::ForEachRouteEdge(VertexId from, VertexId to, EdgeVisitor&& visitor) {
+		++run_;
+		best_weight_.reset();
+		forward_.queue.clear();
+		backward_.queue.clear();
+		forward_.states.at(from) = VertexState{ ZERO_WEIGHT, std::nullopt, run_ };
+		backward_.states.at(to) = VertexState{ ZERO_WEIGHT, std::nullopt, run_ };
+		forward_.queue.push_back({ ZERO_WEIGHT, from });
+		backward_.queue.push_back({ ZERO_WEIGHT, to });
+		UpdateMeeting(from);
+
+		// Путь короче найденного обязан пройти через вершины, ещё не извлечённые обоими поисками,
+		// поэтому когда сумма минимумов очередей не меньше найденного веса, ответ окончателен.
+		// Опустевшая очередь оценивает свою часть нулём: другой поиск ещё может встретить её вершины.
+		// Расширяется направление с меньшей очередью
+		while (true) {
+			const auto forward_min = GetQueueMinimum(forward_);
+			const auto backward_min = GetQueueMinimum(backward_);
+			if (!forward_min && !backward_min) {
+				break;
+			}
+			const Weight lower_bound = AddWeights(forward_min.value_or(ZERO_WEIGHT), backward_min.value_or(ZERO_WEIGHT));
+			if (best_weight_ && !(lower_bound < *best_weight_)) {
+				break;
+			}
+			if (forward_min && (!backward_min || forward_.queue.size() <= backward_.queue.size())) {
+				Step(forward_, backward_, true);
+			}
+			else {
+				Step(backward_, forward_, false);
+			}
+		}
+
+		if (!best_weight_) {
+			return std::nullopt;
+		}
+
+		VisitEdgeChain(forward_.states[meeting_vertex_].edge, [this](EdgeId edge_id) {
+			return forward_.states[graph_.GetEdge(edge_id).from].edge;
+			}, visitor);
+		for (auto edge_id = backward_.states[meeting_vertex_].edge; edge_id;
+			edge_id = backward_.states[graph_.GetEdge(*edge_id).to].edge) {
+			visitor(*edge_id);
+		}
+		return best_weight_;
+	}
+
+	template <typename Weight>
+	std::optional<typename Router<Weight>::RouteInfo> BidirectionalDijkstra<Weight>::BuildRoute(VertexId from, VertexId to) {
+		std::vector<EdgeId> edges;
+		const auto weight = ForEachRouteEdge(from, to, [&edges](EdgeId edge_id) {
+			edges.push_back(edge_id);
+			});
+		if (!weight) {
+			return std::nullopt;
+		}
+
+		return typename Router<Weight>::RouteInfo{ *weight, std::move(edges) };
+	}
+
+} // namespace graph
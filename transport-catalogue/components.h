@@ -0,0 +1,75 @@
+#pragma once
+
+#include "graph.h"
+
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+	// Слабо связные компоненты: вершины разных компонент заведомо не соединены никаким путём,
+	// и это проверяется за O(1). Обратное неверно — внутри компоненты путь в нужную
+	// сторону может отсутствовать, поэтому проверка только отсекает безнадёжные запросы
+	class WeaklyConnectedComponents {
+	public:
+		WeaklyConnectedComponents() = default;
+
+		template <typename Weight>
+		explicit WeaklyConnectedComponents(const DirectedWeightedGraph<Weight>& graph);
+
+		bool AreConnected(VertexId lhs, VertexId rhs) const {
+			return components_.at(lhs) == components_.at(rhs);
+		}
+		size_t GetComponent(VertexId vertex) const { return components_.at(vertex); }
+		size_t GetComponentCount() const { return component_count_; }
+
+	private:
+		std::vector<size_t> components_;
+		size_t component_count_ = 0;
+	};
+
+	template <typename Weight>
+	WeaklyConnectedComponents::WeaklyConnectedComponents(const DirectedWeightedGraph<Weight>& graph) {
+		// Система непересекающихся множеств с сжатием путей и объединением по размеру
+		const size_t vertex_count = graph.GetVertexCount();
+		std::vector<VertexId> parents(vertex_count);
+		std::iota(parents.begin(), parents.end(), VertexId{ 0 });
+		std::vector<size_t> sizes(vertex_count, 1);
+		auto find_root = [&parents](VertexId vertex) {
+			while (parents[vertex] != vertex) {
+				parents[vertex] = parents[parents[vertex]];
+				vertex = parents[vertex];
+			}
+			return vertex;
+		};
+
+		for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+			for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+				VertexId lhs = find_root(vertex);
+				VertexId rhs = find_root(graph.GetEdge(edge_id).to);
+				if (lhs == rhs) {
+					continue;
+				}
+				if (sizes[lhs] < sizes[rhs]) {
+					std::swap(lhs, rhs);
+				}
+				parents[rhs] = lhs;
+				sizes[lhs] += sizes[rhs];
+			}
+		}
+
+		// Компоненты нумеруются подряд в порядке первых вершин
+		constexpr size_t NO_COMPONENT = static_cast<size_t>(-1);
+		std::vector<size_t> root_components(vertex_count, NO_COMPONENT);
+		components_.resize(vertex_count);
+		for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+			size_t& component = root_components[find_root(vertex)];
+			if (component == NO_COMPONENT) {
+				component = component_count_++;
+			}
+			components_[vertex] = component;
+		}
+	}
+
+} // namespace graph
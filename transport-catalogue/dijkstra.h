@@ -0,0 +1,184 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+	// Поиск кратчайших путей из одной вершины.
+	// Состояние переиспользуется между запусками: вершины, не достигнутые в текущем
+	// запуске, распознаются по номеру запуска, поэтому сброс ничего не стоит
+	template <typename Weight>
+	class Dijkstra {
+	private:
+		using Graph = DirectedWeightedGraph<Weight>;
+
+	public:
+		// Поиск идёт по весам профиля profile
+		explicit Dijkstra(const Graph& graph, ProfileId profile = 0);
+
+		// Если задана вершина to, поиск останавливается, как только путь до неё найден
+		void Run(VertexId from, std::optional<VertexId> to = std::nullopt);
+		// Рёбра, для которых is_edge_allowed(edge_id) == false, пропускаются
+		template <typename EdgeFilter>
+		void Run(VertexId from, std::optional<VertexId> to, EdgeFilter&& is_edge_allowed);
+		// Достигаются только вершины с весом не больше max_weight; работа пропорциональна
+		// достигнутой области, а не числу вершин графа
+		void RunWithin(VertexId from, Weight max_weight);
+		template <typename EdgeFilter>
+		void RunWithin(VertexId from, Weight max_weight, EdgeFilter&& is_edge_allowed);
+
+		bool IsReached(VertexId vertex) const;
+		Weight GetWeight(VertexId vertex) const;
+		std::optional<EdgeId> GetPrevEdge(VertexId vertex) const;
+		// Рёбра пути до достигнутой вершины в порядке следования
+		std::vector<EdgeId> GetPathEdges(VertexId to) const;
+		// То же без выделения памяти: рёбра передаются посетителю
+		template <typename EdgeVisitor>
+		void ForEachPathEdge(VertexId to, EdgeVisitor&& visitor) const;
+		// Вершины, достигнутые последним запуском, в порядке первого достижения
+		const std::vector<VertexId>& GetReachedVertices() const;
+
+	private:
+		struct VertexState {
+			Weight weight{};
+			std::optional<EdgeId> prev_edge;
+			size_t run = 0;
+		};
+		using QueueItem = std::pair<Weight, VertexId>;
+
+		template <typename EdgeFilter>
+		void Search(VertexId from, std::optional<VertexId> to, std::optional<Weight> max_weight, EdgeFilter&& is_edge_allowed);
+
+		static constexpr Weight ZERO_WEIGHT{};
+		static constexpr Weight UNREACHABLE = UnreachableWeight<Weight>();
+		const Graph& graph_;
+		ProfileId profile_;
+		std::vector<VertexState> states_;
+		std::vector<QueueItem> queue_;
+		std::vector<VertexId> reached_vertices_;
+		size_t run_ = 0;
+	};
+
+	template <typename Weight>
+	Dijkstra<Weight>::Dijkstra(const Graph& graph, ProfileId profile)
+		: graph_(graph)
+		, profile_(profile)
+		, states_(graph.GetVertexCount())
+	{
+	}
+
+	template <typename Weight>
+	void Dijkstra<Weight>::Run(VertexId from, std::optional<VertexId> to) {
+		Run(from, to, [](EdgeId) { return true; });
+	}
+
+	template <typename Weight>
+	template <typename EdgeFilter>
+	void Dijkstra<Weight>::Run(VertexId from, std::optional<VertexId> to, EdgeFilter&& is_edge_allowed) {
+		Search(from, to, std::nullopt, is_edge_allowed);
+	}
+
+	template <typename Weight>
+	void Dijkstra<Weight>::RunWithin(VertexId from, Weight max_weight) {
+		RunWithin(from, max_weight, [](EdgeId) { return true; });
+	}
+
+	template <typename Weight>
+	template <typename EdgeFilter>
+	void Dijkstra<Weight>::RunWithin(VertexId from, Weight max_weight, EdgeFilter&& is_edge_allowed) {
+		Search(from, std::nullopt, max_weight, is_edge_allowed);
+	}
+
+	template <typename Weight>
+	template <typename EdgeFilter>
+	void Dijkstra<Weight>::Search(VertexId from, std::optional<VertexId> to, std::optional<Weight> max_weight,
+		EdgeFilter&& is_edge_allowed) {
+		++run_;
+		queue_.clear();
+		reached_vertices_.clear();
+		states_.at(from) = VertexState{ ZERO_WEIGHT, std::nullopt, run_ };
+		queue_.push_back({ ZERO_WEIGHT, from });
+		reached_vertices_.push_back(from);
+
+		while (!queue_.empty()) {
+			std::pop_heap(queue_.begin(), queue_.end(), std::greater<QueueItem>{});
+			const auto [weight, vertex] = queue_.back();
+			queue_.pop_back();
+			if (states_[vertex].weight < weight) {
+				continue;
+			}
+			if (to && vertex == *to) {
+				break;
+			}
+			for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+				if (!is_edge_allowed(edge_id)) {
+					continue;
+				}
+				const auto& edge = graph_.GetEdge(edge_id);
+				const Weight edge_weight = graph_.GetEdgeWeight(edge_id, profile_);
+				if (edge_weight < ZERO_WEIGHT) {
+					throw std::domain_error("Edges' weights should be non-negative");
+				}
+				// Путь, чей вес не помещается в тип, считается непроходимым
+				const Weight candidate_weight = AddWeights(weight, edge_weight);
+				if (!(candidate_weight < UNREACHABLE) || (max_weight && *max_weight < candidate_weight)) {
+					continue;
+				}
+				auto& state = states_[edge.to];
+				if (state.run != run_) {
+					reached_vertices_.push_back(edge.to);
+				}
+				if (state.run != run_ || candidate_weight < state.weight) {
+					state = VertexState{ candidate_weight, edge_id, run_ };
+					queue_.push_back({ candidate_weight, edge.to });
+					std::push_heap(queue_.begin(), queue_.end(), std::greater<QueueItem>{});
+				}
+			}
+		}
+	}
+
+	template <typename Weight>
+	bool Dijkstra<Weight>::IsReached(VertexId vertex) const {
+		return states_.at(vertex).run == run_;
+	}
+
+	template <typename Weight>
+	Weight Dijkstra<Weight>::GetWeight(VertexId vertex) const {
+		return states_.at(vertex).weight;
+	}
+
+	template <typename Weight>
+	std::optional<EdgeId> Dijkstra<Weight>::GetPrevEdge(VertexId vertex) const {
+		return states_.at(vertex).prev_edge;
+	}
+
+	template <typename Weight>
+	std::vector<EdgeId> Dijkstra<Weight>::GetPathEdges(VertexId to) const {
+		std::vector<EdgeId> edges;
+		ForEachPathEdge(to, [&edges](EdgeId edge_id) {
+			edges.push_back(edge_id);
+			});
+		return edges;
+	}
+
+	template <typename Weight>
+	template <typename EdgeVisitor>
+	void Dijkstra<Weight>::ForEachPathEdge(VertexId to, EdgeVisitor&& visitor) const {
+		VisitEdgeChain(GetPrevEdge(to), [this](EdgeId edge_id) {
+			return states_[graph_.GetEdge(edge_id).from].prev_edge;
+			}, visitor);
+	}
+
+	template <typename Weight>
+	const std::vector<VertexId>& Dijkstra<Weight>::GetReachedVertices() const {
+		return reached_vertices_;
+	}
+
+} // namespace graph
@@ -2,13 +2,77 @@
 
 #include "ranges.h"
 
+#include <algorithm>
+#include <array>
 #include <cstdlib>
+#include <limits>
+#include <optional>
+#include <string>
 #include <vector>
 
 namespace graph {
 
 	using VertexId = size_t;
 	using EdgeId = size_t;
+	// Набор весов рёбер поверх общей структуры графа; профиль 0 — веса из самих рёбер
+	using ProfileId = size_t;
+
+	// Вес недостижимой ячейки таблицы. Для целых весов берётся половина диапазона,
+	// чтобы сумма двух весов в цикле релаксации не переполнялась
+	template <typename Weight>
+	constexpr Weight UnreachableWeight() {
+		if constexpr (std::numeric_limits<Weight>::has_infinity) {
+			return std::numeric_limits<Weight>::infinity();
+		}
+		else {
+			return std::numeric_limits<Weight>::max() / 2;
+		}
+	}
+
+	// Сумма неотрицательных весов. Целая сумма насыщается на UnreachableWeight: слишком
+	// длинный путь становится недостижимым, а не переполняет тип. Без ветвлений,
+	// чтобы не мешать векторизации циклов релаксации
+	template <typename Weight>
+	constexpr Weight AddWeights(Weight lhs, Weight rhs) {
+		if constexpr (std::numeric_limits<Weight>::has_infinity) {
+			return lhs + rhs;
+		}
+		else {
+			constexpr Weight UNREACHABLE = UnreachableWeight<Weight>();
+			lhs = std::min(lhs, UNREACHABLE);
+			rhs = std::min(rhs, UNREACHABLE);
+			return std::min<Weight>(lhs + rhs, UNREACHABLE);
+		}
+	}
+
+	// Передаёт посетителю в порядке следования рёбра пути, известного с конца:
+	// last_edge — последнее ребро, prev_edge(edge_id) — ребро перед ним или nullopt.
+	// Без рекурсии и без выделения памяти: рёбра собираются с конца блоками
+	// фиксированного размера, и только путь длиннее блока проходится повторно
+	template <typename PrevEdge, typename EdgeVisitor>
+	void VisitEdgeChain(std::optional<EdgeId> last_edge, PrevEdge&& prev_edge, EdgeVisitor&& visitor) {
+		size_t length = 0;
+		for (auto edge_id = last_edge; edge_id; edge_id = prev_edge(*edge_id)) {
+			++length;
+		}
+
+		constexpr size_t BLOCK_SIZE = 64;
+		std::array<EdgeId, BLOCK_SIZE> block;
+		for (size_t begin = 0; begin < length; begin += BLOCK_SIZE) {
+			const size_t end = std::min(begin + BLOCK_SIZE, length);
+			auto edge_id = last_edge;
+			for (size_t i = length; i > end; --i) {
+				edge_id = prev_edge(*edge_id);
+			}
+			for (size_t i = end; i > begin; --i) {
+				block[i - 1 - begin] = *edge_id;
+				edge_id = prev_edge(*edge_id);
+			}
+			for (size_t i = 0; i < end - begin; ++i) {
+				visitor(block[i]);
+			}
+		}
+	}
 
 	template <typename Weight>
 	struct Edge {
@@ -29,20 +93,35 @@ namespace graph {
 		DirectedWeightedGraph() = default;
 		explicit DirectedWeightedGraph(size_t vertex_count);
 		EdgeId AddEdge(const Edge<Weight>& edge);
+		// Ребро исключается из списка инцидентности, но его id остаётся занятым
+		void RemoveEdge(EdgeId edge_id);
 
 		size_t GetVertexCount() const;
 		size_t GetEdgeCount() const;
 		const Edge<Weight>& GetEdge(EdgeId edge_id) const;
 		IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+		// Рёбра, входящие в вершину; нужны поиску в обратном направлении
+		IncidentEdgesRange GetIncomingEdges(VertexId vertex) const;
+
+		// Новый профиль весов: по столбцу весов на профиль, рёбра и списки инцидентности общие.
+		// Изначально веса профиля совпадают с весами рёбер
+		ProfileId AddProfile();
+		size_t GetProfileCount() const;
+		Weight GetEdgeWeight(EdgeId edge_id, ProfileId profile) const;
+		void SetEdgeWeight(EdgeId edge_id, ProfileId profile, Weight weight);
 
 	private:
 		std::vector<Edge<Weight>> edges_;
 		std::vector<IncidenceList> incidence_lists_;
+		std::vector<IncidenceList> reverse_incidence_lists_;
+		// Столбцы весов профилей начиная с первого
+		std::vector<std::vector<Weight>> profile_weights_;
 	};
 
 	template <typename Weight>
 	DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-		: incidence_lists_(vertex_count) {
+		: incidence_lists_(vertex_count)
+		, reverse_incidence_lists_(vertex_count) {
 	}
 
 	template <typename Weight>
@@ -50,9 +129,22 @@ namespace graph {
 		edges_.push_back(edge);
 		const EdgeId id = edges_.size() - 1;
 		incidence_lists_.at(edge.from).push_back(id);
+		reverse_incidence_lists_.at(edge.to).push_back(id);
+		for (auto& weights : profile_weights_) {
+			weights.push_back(edge.weight);
+		}
 		return id;
 	}
 
+	template <typename Weight>
+	void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id) {
+		auto& incidence_list = incidence_lists_.at(edges_.at(edge_id).from);
+		incidence_list.erase(std::remove(incidence_list.begin(), incidence_list.end(), edge_id), incidence_list.end());
+		auto& reverse_incidence_list = reverse_incidence_lists_.at(edges_.at(edge_id).to);
+		reverse_incidence_list.erase(std::remove(reverse_incidence_list.begin(), reverse_incidence_list.end(), edge_id),
+			reverse_incidence_list.end());
+	}
+
 	template <typename Weight>
 	size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
 		return incidence_lists_.size();
@@ -73,4 +165,41 @@ namespace graph {
 		DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
 		return ranges::AsRange(incidence_lists_.at(vertex));
 	}
+
+	template <typename Weight>
+	typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
+		DirectedWeightedGraph<Weight>::GetIncomingEdges(VertexId vertex) const {
+		return ranges::AsRange(reverse_incidence_lists_.at(vertex));
+	}
+
+	template <typename Weight>
+	ProfileId DirectedWeightedGraph<Weight>::AddProfile() {
+		std::vector<Weight> weights;
+		weights.reserve(edges_.size());
+		for (const auto& edge : edges_) {
+			weights.push_back(edge.weight);
+		}
+		profile_weights_.push_back(std::move(weights));
+		return profile_weights_.size();
+	}
+
+	template <typename Weight>
+	size_t DirectedWeightedGraph<Weight>::GetProfileCount() const {
+		return profile_weights_.size() + 1;
+	}
+
+	template <typename Weight>
+	Weight DirectedWeightedGraph<Weight>::GetEdgeWeight(EdgeId edge_id, ProfileId profile) const {
+		return profile == 0 ? edges_[edge_id].weight : profile_weights_[profile - 1][edge_id];
+	}
+
+	template <typename Weight>
+	void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, ProfileId profile, Weight weight) {
+		if (profile == 0) {
+			edges_.at(edge_id).weight = weight;
+		}
+		else {
+			profile_weights_.at(profile - 1).at(edge_id) = weight;
+		}
+	}
 } // namespace graph
@@ -1,83 +1,87 @@
 #include "json.h"
+#include "json_arena.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// JSON_STRUCTURAL_SCALAR оставляет посимвольную классификацию блоков и на x86 — для сравнения
+#if defined(JSON_STRUCTURAL_SCALAR)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define JSON_STRUCTURAL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSON_STRUCTURAL_SSE2
+#endif
 
 namespace json {
 
     namespace {
         using namespace std::literals;
 
-        Node LoadNode(std::istream& input);
-        Node LoadString(std::istream& input);
-
-        std::string LoadLiteral(std::istream& input) {
-            std::string s;
-            while (std::isalpha(input.peek())) {
-                s.push_back(static_cast<char>(input.get()));
-            }
-            return s;
-        }
-
-        Node LoadArray(std::istream& input) {
-            std::vector<Node> result;
+        // Указатель по непрерывному буферу: на каждый символ — сравнение,
+        // а не виртуальные вызовы streambuf, как при чтении из потока.
+        // Строки и скаляры разбираются по нему в границах, найденных индексом
+        struct Input {
+            const char* pos;
+            const char* end;
 
-            for (char c; input >> c && c != ']';) {
-                if (c != ',') {
-                    input.putback(c);
-                }
-                result.push_back(LoadNode(input));
+            bool IsEnd() const {
+                return pos == end;
             }
-            if (!input) {
-                throw ParsingError("Array parsing error"s);
+            // Символ под указателем или '\0' в конце буфера
+            char Peek() const {
+                return pos != end ? *pos : '\0';
             }
-            return Node(std::move(result));
-        }
+        };
 
-        Node LoadDict(std::istream& input) {
-            Dict dict;
+        bool IsDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
 
-            for (char c; input >> c && c != '}';) {
-                if (c == '"') {
-                    std::string key = LoadString(input).AsString();
-                    if (input >> c && c == ':') {
-                        if (dict.find(key) != dict.end()) {
-                            throw ParsingError("Duplicate key '"s + key + "' have been found");
-                        }
-                        dict.emplace(std::move(key), LoadNode(input));
-                    }
-                    else {
-                        throw ParsingError(": is expected but '"s + c + "' has been found"s);
-                    }
-                }
-                else if (c != ',') {
-                    throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
-                }
+        std::string_view LoadLiteral(Input& input) {
+            const char* begin = input.pos;
+            while (!input.IsEnd() && std::isalpha(static_cast<unsigned char>(*input.pos))) {
+                ++input.pos;
             }
-            if (!input) {
-                throw ParsingError("Dictionary parsing error"s);
-            }
-            return Node(std::move(dict));
+            return { begin, static_cast<size_t>(input.pos - begin) };
         }
 
-        Node LoadString(std::istream& input) {
-            auto it = std::istreambuf_iterator<char>(input);
-            auto end = std::istreambuf_iterator<char>();
+        std::string LoadString(Input& input) {
             std::string s;
             while (true) {
-                if (it == end) {
+                // Обычные символы копируются куском до ближайшего особого
+                const char* begin = input.pos;
+                while (input.pos != input.end && *input.pos != '"' && *input.pos != '\\'
+                    && *input.pos != '\n' && *input.pos != '\r') {
+                    ++input.pos;
+                }
+                s.append(begin, input.pos);
+                if (input.IsEnd()) {
                     throw ParsingError("String parsing error");
                 }
-                const char ch = *it;
+                const char ch = *input.pos++;
                 if (ch == '"') {
-                    ++it;
                     break;
                 }
                 else if (ch == '\\') {
-                    ++it;
-                    if (it == end) {
+                    if (input.IsEnd()) {
                         throw ParsingError("String parsing error");
                     }
-                    const char escaped_char = *(it);
+                    const char escaped_char = *input.pos++;
                     switch (escaped_char) {
                     case 'n':
                         s.push_back('\n');
@@ -98,19 +102,15 @@ namespace json {
                         throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
                     }
                 }
-                else if (ch == '\n' || ch == '\r') {
-                    throw ParsingError("Unexpected end of line"s);
-                }
                 else {
-                    s.push_back(ch);
+                    throw ParsingError("Unexpected end of line"s);
                 }
-                ++it;
             }
 
-            return Node(std::move(s));
+            return s;
         }
 
-        Node LoadBool(std::istream& input) {
+        Node LoadBool(Input& input) {
             const auto s = LoadLiteral(input);
             if (s == "true"sv) {
                 return Node{ true };
@@ -119,46 +119,38 @@ namespace json {
                 return Node{ false };
             }
             else {
-                throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+                throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
             }
         }
 
-        Node LoadNull(std::istream& input) {
+        Node LoadNull(Input& input) {
             if (auto literal = LoadLiteral(input); literal == "null"sv) {
                 return Node{ nullptr };
             }
             else {
-                throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+                throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
             }
         }
 
-        Node LoadNumber(std::istream& input) {
-            std::string parsed_num;
+        Node LoadNumber(Input& input) {
+            const char* begin = input.pos;
 
-            // Считывает в parsed_num очередной символ из input
-            auto read_char = [&parsed_num, &input] {
-                parsed_num += static_cast<char>(input.get());
-                if (!input) {
-                    throw ParsingError("Failed to read number from stream"s);
-                }
-            };
-
-            // Считывает одну или более цифр в parsed_num из input
-            auto read_digits = [&input, read_char] {
-                if (!std::isdigit(input.peek())) {
+            // Пропускает одну или более цифр
+            auto read_digits = [&input] {
+                if (!IsDigit(input.Peek())) {
                     throw ParsingError("A digit is expected"s);
                 }
-                while (std::isdigit(input.peek())) {
-                    read_char();
+                while (IsDigit(input.Peek())) {
+                    ++input.pos;
                 }
             };
 
-            if (input.peek() == '-') {
-                read_char();
+            if (input.Peek() == '-') {
+                ++input.pos;
             }
             // Парсим целую часть числа
-            if (input.peek() == '0') {
-                read_char();
+            if (input.Peek() == '0') {
+                ++input.pos;
                 // После 0 в JSON не могут идти другие цифры
             }
             else {
@@ -167,130 +159,598 @@ namespace json {
 
             bool is_int = true;
             // Парсим дробную часть числа
-            if (input.peek() == '.') {
-                read_char();
+            if (input.Peek() == '.') {
+                ++input.pos;
                 read_digits();
                 is_int = false;
             }
 
             // Парсим экспоненциальную часть числа
-            if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-                read_char();
-                if (ch = input.peek(); ch == '+' || ch == '-') {
-                    read_char();
+            if (char ch = input.Peek(); ch == 'e' || ch == 'E') {
+                ++input.pos;
+                if (ch = input.Peek(); ch == '+' || ch == '-') {
+                    ++input.pos;
                 }
                 read_digits();
                 is_int = false;
             }
 
-            try {
-                if (is_int) {
-                    // Сначала пробуем преобразовать строку в int
-                    try {
-                        return std::stoi(parsed_num);
-                    }
-                    catch (...) {
-                        // В случае неудачи, например, при переполнении
-                        // код ниже попробует преобразовать строку в double
-                    }
+            // Число преобразуется прямо из текста, без промежуточной строки
+            if (is_int) {
+                // Сначала пробуем преобразовать в int; при переполнении
+                // код ниже попробует преобразовать в double
+                int value = 0;
+                if (const auto [end, ec] = std::from_chars(begin, input.pos, value); ec == std::errc{} && end == input.pos) {
+                    return value;
                 }
-                return std::stod(parsed_num);
-            }
-            catch (...) {
-                throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
-            }
-        }
-
-        Node LoadNode(std::istream& input) {
-            char c;
-            if (!(input >> c)) {
-                throw ParsingError("Unexpected EOF"s);
-            }
-            switch (c) {
-            case '[':
-                return LoadArray(input);
-            case '{':
-                return LoadDict(input);
-            case '"':
-                return LoadString(input);
-            case 't':
-                // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
-                // подсказкой компилятору и человеку, что здесь программист явно задумывал
-                // разрешить переход к инструкции следующей ветки case, а не случайно забыл
-                // написать break, return или throw.
-                // В данном случае, встретив t или f, переходим к попытке парсинга
-                // литералов true либо false
-                [[fallthrough]];
-            case 'f':
-                input.putback(c);
-                return LoadBool(input);
-            case 'n':
-                input.putback(c);
-                return LoadNull(input);
-            default:
-                input.putback(c);
-                return LoadNumber(input);
             }
+            double value = 0.0;
+            if (const auto [end, ec] = std::from_chars(begin, input.pos, value); ec == std::errc{} && end == input.pos) {
+                return value;
+            }
+            throw ParsingError("Failed to convert "s + std::string(begin, input.pos) + " to number"s);
         }
 
-        struct PrintContext {
-            std::ostream& out;
-            int indent_step = 4;
-            int indent = 0;
+        // Первый этап разбора: индекс структурных позиций — скобок, запятых и двоеточий вне строк,
+        // неэкранированных кавычек и начал скаляров. Текст классифицируется блоками по 64 байта:
+        // каждому классу символов соответствует 64-битная маска, и экранирование, границы строк
+        // и начала скаляров считаются битовыми операциями над масками, а не посимвольно.
+        // Индекс строится порциями по мере разбора, чтобы оставаться в кэше.
+        // Поток читается теми же порциями: в памяти держится текст от позиции, которую разбор
+        // прошёл последней, так что буфер не больше порции и самого длинного токена
+        class StructuralIndex {
+        public:
+            explicit StructuralIndex(std::string_view text)
+                : text_(text) {
+            }
+            explicit StructuralIndex(std::istream& input)
+                : input_(&input) {
+            }
 
-            void PrintIndent() const {
-                for (int i = 0; i < indent; ++i) {
-                    out.put(' ');
+            bool IsEnd() {
+                if (next_ == positions_.size()) {
+                    IndexNextChunk();
                 }
+                return next_ == positions_.size();
+            }
+            // Позиция очередного элемента; перед вызовом IsEnd() должен вернуть false
+            size_t Peek() const {
+                return positions_[next_];
+            }
+            void Advance() {
+                ++next_;
+            }
+            // Граница текущего элемента: позиция следующего или конец текста
+            size_t GetNextBoundary() {
+                ++next_;
+                const size_t boundary = IsEnd() ? base_ + text_.size() : Peek();
+                --next_;
+                return boundary;
             }
 
-            PrintContext Indented() const {
-                return { out, indent_step, indent_step + indent };
+            // Текст доступен от последней пройденной позиции; чтение следующей порции
+            // может сдвинуть буфер, поэтому ссылки в текст действительны до следующего IsEnd()
+            char At(size_t pos) const {
+                return text_[pos - base_];
+            }
+            std::string_view Slice(size_t begin, size_t end) const {
+                return text_.substr(begin - base_, end - begin);
             }
+
+        private:
+            static constexpr size_t BLOCK_SIZE = 64;
+            static constexpr size_t CHUNK_SIZE = 1024 * BLOCK_SIZE;
+
+            struct BlockMasks {
+                std::uint64_t quotes = 0;
+                std::uint64_t backslashes = 0;
+                std::uint64_t structurals = 0;
+                std::uint64_t spaces = 0;
+            };
+
+            static BlockMasks ClassifyBlock(const char* block);
+            void IndexBlock(const char* block, size_t offset);
+            void IndexNextChunk();
+            void ReadChunk(size_t keep_from);
+
+            std::string_view text_;
+            // При чтении из потока text_ — окно buffer_, начинающееся с позиции base_ во входе
+            std::istream* input_ = nullptr;
+            std::string buffer_;
+            size_t base_ = 0;
+            size_t indexed_size_ = 0;
+            std::vector<size_t> positions_;
+            size_t next_ = 0;
+            // Перенос состояния между блоками: первый символ блока экранирован,
+            // блок начинается внутри строки, предыдущий блок кончается скаляром
+            std::uint64_t is_escaped_ = 0;
+            std::uint64_t is_in_string_ = 0;
+            std::uint64_t is_in_scalar_ = 0;
         };
 
-        void PrintNode(const Node& value, const PrintContext& ctx);
+        std::uint64_t PrefixXor(std::uint64_t bits) {
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
+        }
 
-        template <typename Value>
-        void PrintValue(const Value& value, const PrintContext& ctx) {
-            ctx.out << value;
+        size_t CountTrailingZeros(std::uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<size_t>(__builtin_ctzll(bits));
+#else
+            size_t count = 0;
+            for (; !(bits & 1); bits >>= 1) {
+                ++count;
+            }
+            return count;
+#endif
+        }
+
+#if defined(JSON_STRUCTURAL_AVX2)
+        StructuralIndex::BlockMasks StructuralIndex::ClassifyBlock(const char* block) {
+            BlockMasks masks;
+            for (size_t half = 0; half < 2; ++half) {
+                const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + half * 32));
+                auto match = [&chars](char c) {
+                    return _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(c));
+                };
+                auto to_mask = [half](__m256i matches) {
+                    return std::uint64_t{ static_cast<std::uint32_t>(_mm256_movemask_epi8(matches)) } << (half * 32);
+                };
+                const __m256i structurals = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_or_si256(match('{'), match('}')), _mm256_or_si256(match('['), match(']'))),
+                    _mm256_or_si256(match(','), match(':')));
+                // Пробельные — ' ' и коды 9..13, как у std::isspace
+                const __m256i shifted = _mm256_sub_epi8(chars, _mm256_set1_epi8('\t'));
+                const __m256i spaces = _mm256_or_si256(match(' '),
+                    _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8('\r' - '\t')), shifted));
+                masks.quotes |= to_mask(match('"'));
+                masks.backslashes |= to_mask(match('\\'));
+                masks.structurals |= to_mask(structurals);
+                masks.spaces |= to_mask(spaces);
+            }
+            return masks;
+        }
+#elif defined(JSON_STRUCTURAL_SSE2)
+        StructuralIndex::BlockMasks StructuralIndex::ClassifyBlock(const char* block) {
+            BlockMasks masks;
+            for (size_t quarter = 0; quarter < 4; ++quarter) {
+                const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + quarter * 16));
+                auto match = [&chars](char c) {
+                    return _mm_cmpeq_epi8(chars, _mm_set1_epi8(c));
+                };
+                auto to_mask = [quarter](__m128i matches) {
+                    return std::uint64_t{ static_cast<std::uint32_t>(_mm_movemask_epi8(matches)) } << (quarter * 16);
+                };
+                const __m128i structurals = _mm_or_si128(
+                    _mm_or_si128(_mm_or_si128(match('{'), match('}')), _mm_or_si128(match('['), match(']'))),
+                    _mm_or_si128(match(','), match(':')));
+                // Пробельные — ' ' и коды 9..13, как у std::isspace
+                const __m128i shifted = _mm_sub_epi8(chars, _mm_set1_epi8('\t'));
+                const __m128i spaces = _mm_or_si128(match(' '),
+                    _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted));
+                masks.quotes |= to_mask(match('"'));
+                masks.backslashes |= to_mask(match('\\'));
+                masks.structurals |= to_mask(structurals);
+                masks.spaces |= to_mask(spaces);
+            }
+            return masks;
+        }
+#else
+        StructuralIndex::BlockMasks StructuralIndex::ClassifyBlock(const char* block) {
+            BlockMasks masks;
+            for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+                const std::uint64_t bit = std::uint64_t{ 1 } << i;
+                switch (block[i]) {
+                case '"':
+                    masks.quotes |= bit;
+                    break;
+                case '\\':
+                    masks.backslashes |= bit;
+                    break;
+                case '{': case '}': case '[': case ']': case ',': case ':':
+                    masks.structurals |= bit;
+                    break;
+                case ' ': case '\t': case '\n': case '\v': case '\f': case '\r':
+                    masks.spaces |= bit;
+                    break;
+                default:
+                    break;
+                }
+            }
+            return masks;
+        }
+#endif
+
+        void StructuralIndex::IndexBlock(const char* block, size_t offset) {
+            const BlockMasks masks = ClassifyBlock(block);
+
+            // Символ после неэкранированной обратной косой черты экранирован.
+            // Косые черты редки, поэтому обходятся по одной
+            std::uint64_t escaped = is_escaped_;
+            is_escaped_ = 0;
+            for (std::uint64_t bits = masks.backslashes & ~escaped; bits != 0; bits &= bits - 1) {
+                const size_t i = CountTrailingZeros(bits);
+                if ((escaped >> i) & 1) {
+                    continue;
+                }
+                if (i + 1 == BLOCK_SIZE) {
+                    is_escaped_ = 1;
+                }
+                else {
+                    escaped |= std::uint64_t{ 1 } << (i + 1);
+                }
+            }
+
+            // Внутри строки — от открывающей кавычки включительно до закрывающей
+            const std::uint64_t quotes = masks.quotes & ~escaped;
+            const std::uint64_t in_string = PrefixXor(quotes) ^ (std::uint64_t{ 0 } - is_in_string_);
+            is_in_string_ = in_string >> 63;
+
+            const std::uint64_t scalars = ~(masks.spaces | masks.structurals | quotes | in_string);
+            const std::uint64_t scalar_starts = scalars & ~((scalars << 1) | is_in_scalar_);
+            is_in_scalar_ = scalars >> 63;
+
+            for (std::uint64_t bits = (masks.structurals & ~in_string) | quotes | scalar_starts; bits != 0; bits &= bits - 1) {
+                positions_.push_back(offset + CountTrailingZeros(bits));
+            }
         }
 
-        void PrintString(const std::string& value, std::ostream& out) {
-            out.put('"');
-            for (const char c : value) {
-                switch (c) {
-                case '\r':
-                    out << "\\r"sv;
+        void StructuralIndex::ReadChunk(size_t keep_from) {
+            buffer_.erase(0, keep_from - base_);
+            base_ = keep_from;
+            const size_t size = buffer_.size();
+            buffer_.resize(size + CHUNK_SIZE);
+            input_->read(buffer_.data() + size, CHUNK_SIZE);
+            buffer_.resize(size + static_cast<size_t>(input_->gcount()));
+            if (input_->gcount() < static_cast<std::streamsize>(CHUNK_SIZE)) {
+                input_ = nullptr;
+            }
+            text_ = buffer_;
+        }
+
+        void StructuralIndex::IndexNextChunk() {
+            // Разбор ещё может обратиться к элементу, начатому последней пройденной позицией:
+            // к открывающей кавычке строки или началу скаляра
+            const size_t keep_from = next_ > 0 ? positions_[next_ - 1] : indexed_size_;
+            positions_.clear();
+            next_ = 0;
+            // Порция может целиком лежать внутри длинной строки и не дать ни одной позиции
+            while (positions_.empty()) {
+                if (input_ && indexed_size_ + CHUNK_SIZE > base_ + text_.size()) {
+                    ReadChunk(keep_from);
+                }
+                const size_t text_end = base_ + text_.size();
+                if (indexed_size_ == text_end) {
                     break;
-                case '\n':
-                    out << "\\n"sv;
+                }
+                const size_t chunk_end = std::min(text_end, indexed_size_ + CHUNK_SIZE);
+                for (; indexed_size_ + BLOCK_SIZE <= chunk_end; indexed_size_ += BLOCK_SIZE) {
+                    IndexBlock(text_.data() + indexed_size_ - base_, indexed_size_);
+                }
+                if (indexed_size_ < chunk_end) {
+                    // Хвост текста дополняется пробелами до целого блока. Неполная порция
+                    // бывает только в конце входа: из потока читаются порции целиком
+                    char block[BLOCK_SIZE];
+                    std::fill(std::copy(text_.data() + indexed_size_ - base_, text_.data() + chunk_end - base_, block),
+                        block + BLOCK_SIZE, ' ');
+                    IndexBlock(block, indexed_size_);
+                    indexed_size_ = chunk_end;
+                }
+            }
+        }
+
+        // Второй этап: обход по индексу с событиями для обработчика. Скобки и разделители
+        // берутся прямо из индекса, строки и скаляры разбираются в границах до следующей позиции.
+        // Sink — json::Handler для потокового разбора, DocumentBuilder для Load
+        // или ArenaBuilder для LoadArena
+        template <typename Sink>
+        class Parser {
+        public:
+            Parser(std::string_view text, Sink& sink)
+                : index_(text)
+                , sink_(sink) {
+            }
+            Parser(std::istream& input, Sink& sink)
+                : index_(input)
+                , sink_(sink) {
+            }
+
+            void ParseValue() {
+                if (index_.IsEnd()) {
+                    throw ParsingError("Unexpected EOF"s);
+                }
+                switch (index_.At(index_.Peek())) {
+                case '[':
+                    index_.Advance();
+                    ParseArray();
                     break;
-                case '\t':
-                    out << "\\t"sv;
+                case '{':
+                    index_.Advance();
+                    ParseDict();
                     break;
                 case '"':
-                    // Символы " и \ выводятся как \" или \\, соответственно
-                    [[fallthrough]];
-                case '\\':
-                    out.put('\\');
+                    sink_.String(LoadStringToken());
+                    break;
+                default:
+                    sink_.Value(LoadScalar());
+                    break;
+                }
+            }
+
+        private:
+            void ParseArray() {
+                sink_.StartArray();
+                while (true) {
+                    if (index_.IsEnd()) {
+                        throw ParsingError("Array parsing error"s);
+                    }
+                    const char c = index_.At(index_.Peek());
+                    if (c == ']') {
+                        index_.Advance();
+                        break;
+                    }
+                    if (c == ',') {
+                        index_.Advance();
+                    }
+                    ParseValue();
+                }
+                sink_.EndArray();
+            }
+
+            void ParseDict() {
+                sink_.StartDict();
+                while (true) {
+                    if (index_.IsEnd()) {
+                        throw ParsingError("Dictionary parsing error"s);
+                    }
+                    const char c = index_.At(index_.Peek());
+                    if (c == '}') {
+                        index_.Advance();
+                        break;
+                    }
+                    if (c == '"') {
+                        // Ключ передаётся до обращения к индексу: чтение следующей порции
+                        // из потока сдвигает буфер, на который он ссылается
+                        sink_.Key(LoadStringToken());
+                        const char separator = index_.IsEnd() ? '\0' : index_.At(index_.Peek());
+                        if (separator != ':') {
+                            throw ParsingError(": is expected but '"s + separator + "' has been found"s);
+                        }
+                        index_.Advance();
+                        ParseValue();
+                    }
+                    else if (c == ',') {
+                        index_.Advance();
+                    }
+                    else {
+                        throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+                    }
+                }
+                sink_.EndDict();
+            }
+
+            // Открывающая и закрывающая кавычки — соседние позиции индекса.
+            // Строка без экранирования возвращается ссылкой во входной текст, остальные
+            // раскодируются в буфер разборщика и действительны до следующей строки
+            std::string_view LoadStringToken() {
+                const size_t open = index_.Peek();
+                index_.Advance();
+                if (index_.IsEnd()) {
+                    throw ParsingError("String parsing error");
+                }
+                const size_t close = index_.Peek();
+                index_.Advance();
+                const std::string_view body = index_.Slice(open + 1, close);
+                if (body.find_first_of("\\\n\r"sv) == std::string_view::npos) {
+                    return body;
+                }
+                Input input{ body.data(), body.data() + body.size() + 1 };
+                decoded_ = LoadString(input);
+                return decoded_;
+            }
+
+            // Скаляр занимает всё до следующей позиции индекса, кроме пробелов в конце
+            Node LoadScalar() {
+                const size_t begin = index_.Peek();
+                const size_t end = index_.GetNextBoundary();
+                index_.Advance();
+                const std::string_view token = index_.Slice(begin, end);
+                Input input{ token.data(), token.data() + token.size() };
+                Node result;
+                switch (token.front()) {
+                case 't':
                     [[fallthrough]];
+                case 'f':
+                    result = LoadBool(input);
+                    break;
+                case 'n':
+                    result = LoadNull(input);
+                    break;
                 default:
-                    out.put(c);
+                    result = LoadNumber(input);
                     break;
                 }
+                while (!input.IsEnd() && std::isspace(static_cast<unsigned char>(*input.pos))) {
+                    ++input.pos;
+                }
+                if (!input.IsEnd()) {
+                    throw ParsingError("Unexpected character '"s + *input.pos + "' after a value"s);
+                }
+                return result;
+            }
+
+            StructuralIndex index_;
+            Sink& sink_;
+            std::string decoded_;
+        };
+
+        // Собирает документ из событий. Элементы всех открытых массивов и пары всех открытых
+        // словарей копятся в общих стеках; при закрытии контейнер забирает свой хвост стека
+        // одним выделением памяти точного размера, а пары словаря сортируются один раз
+        class DocumentBuilder {
+        public:
+            void StartDict() {
+                open_containers_.push_back({ true, items_.size() });
+            }
+            void Key(std::string_view key) {
+                keys_.emplace_back(key);
+            }
+            void EndDict() {
+                const auto begin = items_.begin() + open_containers_.back().begin;
+                open_containers_.pop_back();
+                // Равные ключи — ошибка, так что устойчивость сортировки не нужна
+                auto less = [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+                    return lhs.first < rhs.first;
+                };
+                std::sort(begin, items_.end(), less);
+                const auto duplicate = std::adjacent_find(begin, items_.end(),
+                    [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+                        return lhs.first == rhs.first;
+                    });
+                if (duplicate != items_.end()) {
+                    throw ParsingError("Duplicate key '"s + duplicate->first + "' have been found");
+                }
+                Dict dict(std::vector<Dict::value_type>(std::make_move_iterator(begin), std::make_move_iterator(items_.end())));
+                items_.erase(begin, items_.end());
+                Add(Node(std::move(dict)));
+            }
+            void StartArray() {
+                open_containers_.push_back({ false, values_.size() });
+            }
+            void EndArray() {
+                const auto begin = values_.begin() + open_containers_.back().begin;
+                open_containers_.pop_back();
+                Array array(std::make_move_iterator(begin), std::make_move_iterator(values_.end()));
+                values_.erase(begin, values_.end());
+                Add(Node(std::move(array)));
+            }
+            void String(std::string_view value) {
+                Add(Node(std::string(value)));
+            }
+            void Value(Node value) {
+                Add(std::move(value));
+            }
+
+            Node ExtractRoot() {
+                return std::move(root_);
+            }
+
+        private:
+            struct OpenContainer {
+                bool is_dict;
+                // Начало элементов контейнера в items_ или values_
+                size_t begin;
+            };
+
+            void Add(Node value) {
+                if (open_containers_.empty()) {
+                    root_ = std::move(value);
+                }
+                else if (!open_containers_.back().is_dict) {
+                    values_.push_back(std::move(value));
+                }
+                else {
+                    items_.emplace_back(std::move(keys_.back()), std::move(value));
+                    keys_.pop_back();
+                }
+            }
+
+            Node root_;
+            std::vector<OpenContainer> open_containers_;
+            std::vector<Node> values_;
+            std::vector<Dict::value_type> items_;
+            std::vector<std::string> keys_;
+        };
+
+        // Для LoadArena: узлы арены ссылаются на текст, поэтому поток вычитывается целиком
+        std::string ReadAll(std::istream& input) {
+            std::string text;
+            char chunk[1 << 16];
+            while (input.read(chunk, sizeof(chunk)) || input.gcount() > 0) {
+                text.append(chunk, static_cast<size_t>(input.gcount()));
             }
-            out.put('"');
+            return text;
+        }
+
+        // Символы, которые Print выводит экранированными
+        bool NeedsEscape(char c) {
+            return c == '"' || c == '\\' || c == '\n' || c == '\r' || c == '\t';
+        }
+
+        // Первый символ, требующий экранирования, или end. Строки проверяются по 16 байт
+        // за сравнение, и чистые участки между найденными символами копируются целиком
+        const char* FindEscape(const char* pos, const char* end) {
+#if defined(JSON_STRUCTURAL_AVX2) || defined(JSON_STRUCTURAL_SSE2)
+            for (; end - pos >= 16; pos += 16) {
+                const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+                auto match = [&chars](char c) {
+                    return _mm_cmpeq_epi8(chars, _mm_set1_epi8(c));
+                };
+                const __m128i escapes = _mm_or_si128(_mm_or_si128(match('"'), match('\\')),
+                    _mm_or_si128(_mm_or_si128(match('\n'), match('\r')), match('\t')));
+                if (const int mask = _mm_movemask_epi8(escapes); mask != 0) {
+                    return pos + CountTrailingZeros(static_cast<std::uint32_t>(mask));
+                }
+            }
+#endif
+            while (pos != end && !NeedsEscape(*pos)) {
+                ++pos;
+            }
+            return pos;
+        }
+
+        struct PrintContext {
+            Writer& out;
+            const PrintOptions& options;
+            int indent_step = 4;
+            int indent = 0;
+
+            // Перевод строки перед элементом контейнера или закрывающей скобкой
+            void PrintLineBreak() const {
+                if (!options.compact) {
+                    out.Put('\n');
+                }
+            }
+
+            void PrintIndent() const {
+                for (int i = 0; !options.compact && i < indent; ++i) {
+                    out.Put(' ');
+                }
+            }
+
+            PrintContext Indented() const {
+                return { out, options, indent_step, indent_step + indent };
+            }
+        };
+
+        void PrintNode(const Node& value, const PrintContext& ctx);
+
+        template <typename Value>
+        void PrintValue(const Value& value, const PrintContext& ctx);
+
+        template <>
+        void PrintValue<int>(const int& value, const PrintContext& ctx) {
+            ctx.out.WriteInt(value);
+        }
+
+        template <>
+        void PrintValue<double>(const double& value, const PrintContext& ctx) {
+            ctx.out.WriteDouble(value, ctx.options);
         }
 
         template <>
         void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
-            PrintString(value, ctx.out);
+            ctx.out.WriteString(value);
         }
 
         template <>
         void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
-            ctx.out << "null"sv;
+            ctx.out.Write("null"sv);
         }
 
         // В специализации шаблона PrintValue для типа bool параметр value передаётся
@@ -299,13 +759,14 @@ namespace json {
         // void PrintValue(bool value, const PrintContext& ctx);
         template <>
         void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
-            ctx.out << (value ? "true"sv : "false"sv);
+            ctx.out.Write(value ? "true"sv : "false"sv);
         }
 
         template <>
         void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
-            std::ostream& out = ctx.out;
-            out << "[\n"sv;
+            Writer& out = ctx.out;
+            out.Put('[');
+            ctx.PrintLineBreak();
             bool first = true;
             auto inner_ctx = ctx.Indented();
             for (const Node& node : nodes) {
@@ -313,20 +774,22 @@ namespace json {
                     first = false;
                 }
                 else {
-                    out << ",\n"sv;
+                    out.Put(',');
+                    ctx.PrintLineBreak();
                 }
                 inner_ctx.PrintIndent();
                 PrintNode(node, inner_ctx);
             }
-            out.put('\n');
+            ctx.PrintLineBreak();
             ctx.PrintIndent();
-            out.put(']');
+            out.Put(']');
         }
 
         template <>
         void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
-            std::ostream& out = ctx.out;
-            out << "{\n"sv;
+            Writer& out = ctx.out;
+            out.Put('{');
+            ctx.PrintLineBreak();
             bool first = true;
             auto inner_ctx = ctx.Indented();
             for (const auto& [key, node] : nodes) {
@@ -334,16 +797,17 @@ namespace json {
                     first = false;
                 }
                 else {
-                    out << ",\n"sv;
+                    out.Put(',');
+                    ctx.PrintLineBreak();
                 }
                 inner_ctx.PrintIndent();
-                PrintString(key, ctx.out);
-                out << ": "sv;
+                out.WriteString(key);
+                out.Write(ctx.options.compact ? ":"sv : ": "sv);
                 PrintNode(node, inner_ctx);
             }
-            out.put('\n');
+            ctx.PrintLineBreak();
             ctx.PrintIndent();
-            out.put('}');
+            out.Put('}');
         }
 
         void PrintNode(const Node& node, const PrintContext& ctx) {
@@ -356,12 +820,242 @@ namespace json {
 
     }  // namespace
 
+    Document Load(std::string_view text) {
+        DocumentBuilder builder;
+        Parser<DocumentBuilder>(text, builder).ParseValue();
+        return Document{ builder.ExtractRoot() };
+    }
+
     Document Load(std::istream& input) {
-        return Document{ LoadNode(input) };
+        DocumentBuilder builder;
+        Parser<DocumentBuilder>(input, builder).ParseValue();
+        return Document{ builder.ExtractRoot() };
+    }
+
+    void Parse(std::string_view text, Handler& handler) {
+        Parser<Handler>(text, handler).ParseValue();
+    }
+
+    void Parse(std::istream& input, Handler& handler) {
+        Parser<Handler>(input, handler).ParseValue();
+    }
+
+    ArenaDocument LoadArena(std::string text) {
+        ArenaDocument document;
+        document.text_ = std::make_unique<const std::string>(std::move(text));
+        // Первый блок арены — по размеру текста, дальше она растёт геометрически, так что блоков единицы
+        document.arena_ = std::make_unique<std::pmr::monotonic_buffer_resource>(document.text_->size() + 1024);
+        ArenaBuilder builder(document.arena_.get(), *document.text_);
+        Parser<ArenaBuilder>(*document.text_, builder).ParseValue();
+        document.root_ = builder.GetRoot();
+        return document;
+    }
+
+    ArenaDocument LoadArena(std::istream& input) {
+        return LoadArena(ReadAll(input));
+    }
+
+    Writer::Writer(int fd, size_t capacity)
+        : buffer_(std::make_unique<char[]>(capacity))
+        , capacity_(capacity)
+        , fd_(fd) {
+    }
+
+    Writer::Writer(std::ostream& output, size_t capacity)
+        : buffer_(std::make_unique<char[]>(capacity))
+        , capacity_(capacity)
+        , output_(&output) {
+    }
+
+    Writer::Writer(std::string& output)
+        : capacity_(0)
+        , text_(&output) {
+    }
+
+    Writer::~Writer() {
+        try {
+            Flush();
+        }
+        catch (...) {
+        }
+    }
+
+    void Writer::Write(std::string_view text) {
+        if (text_) {
+            text_->append(text);
+            return;
+        }
+        if (text.size() > capacity_ - size_) {
+            if (text.size() >= capacity_) {
+                // Крупный кусок уходит вместе с буфером одним вызовом, без копирования
+                Drain(text);
+                return;
+            }
+            Drain();
+        }
+        std::memcpy(buffer_.get() + size_, text.data(), text.size());
+        size_ += text.size();
+    }
+
+    void Writer::Put(char c) {
+        if (text_) {
+            text_->push_back(c);
+            return;
+        }
+        if (size_ == capacity_) {
+            Drain();
+        }
+        buffer_[size_++] = c;
+    }
+
+    void Writer::WriteString(std::string_view value) {
+        Put('"');
+        const char* pos = value.data();
+        const char* const end = pos + value.size();
+        while (pos != end) {
+            const char* escape = FindEscape(pos, end);
+            Write({ pos, static_cast<size_t>(escape - pos) });
+            if (escape == end) {
+                break;
+            }
+            Put('\\');
+            switch (*escape) {
+            case '\r':
+                Put('r');
+                break;
+            case '\n':
+                Put('n');
+                break;
+            case '\t':
+                Put('t');
+                break;
+            default:
+                // Символы " и \ выводятся как \" или \\, соответственно
+                Put(*escape);
+                break;
+            }
+            pos = escape + 1;
+        }
+        Put('"');
+    }
+
+    void Writer::WriteInt(int value) {
+        char buffer[16];
+        const auto result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+        Write({ buffer, static_cast<size_t>(result.ptr - buffer) });
+    }
+
+    void Writer::WriteDouble(double value, const PrintOptions& options) {
+        // Самая длинная запись — fixed для 1e308 с заданной точностью
+        char buffer[512];
+        std::to_chars_result result;
+        switch (options.number_format) {
+        case NumberFormat::Shortest:
+            result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+            break;
+        case NumberFormat::Fixed:
+            result = std::to_chars(std::begin(buffer), std::end(buffer), value, std::chars_format::fixed, options.precision);
+            break;
+        default:
+            result = std::to_chars(std::begin(buffer), std::end(buffer), value, std::chars_format::general, options.precision);
+            break;
+        }
+        if (result.ec != std::errc{}) {
+            throw std::invalid_argument("Failed to format a number with precision "s + std::to_string(options.precision));
+        }
+        Write({ buffer, static_cast<size_t>(result.ptr - buffer) });
+    }
+
+    void Writer::Flush() {
+        Drain();
+        if (output_) {
+            output_->flush();
+        }
+    }
+
+    void Writer::Drain(std::string_view tail) {
+        if (text_) {
+            text_->append(tail);
+            return;
+        }
+        if (output_) {
+            output_->write(buffer_.get(), static_cast<std::streamsize>(size_));
+            output_->write(tail.data(), static_cast<std::streamsize>(tail.size()));
+            size_ = 0;
+            return;
+        }
+        std::string_view head(buffer_.get(), size_);
+        // Буфер отмечается пустым сразу: после ошибки записи его содержимое не повторяется
+        size_ = 0;
+        while (!head.empty() || !tail.empty()) {
+#if defined(_WIN32)
+            const std::string_view& part = head.empty() ? tail : head;
+            const auto written = _write(fd_, part.data(), static_cast<unsigned>(std::min<size_t>(part.size(), 1u << 30)));
+#else
+            iovec parts[2] = {
+                { const_cast<char*>(head.data()), head.size() },
+                { const_cast<char*>(tail.data()), tail.size() }
+            };
+            const auto written = head.empty() ? ::write(fd_, tail.data(), tail.size()) : ::writev(fd_, parts, 2);
+#endif
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "Failed to write JSON output");
+            }
+            // Частичная запись: досылается остаток
+            auto consumed = static_cast<size_t>(written);
+            const size_t from_head = std::min(consumed, head.size());
+            head.remove_prefix(from_head);
+            tail.remove_prefix(consumed - from_head);
+        }
+    }
+
+    ArrayPrinter::ArrayPrinter(Writer& writer, const PrintOptions& options)
+        : writer_(writer)
+        , options_(options) {
+        writer_.Put('[');
+        PrintContext{ writer_, options_ }.PrintLineBreak();
+    }
+
+    void ArrayPrinter::Add(const Node& item) {
+        Print(item, NextItem(), options_, GetItemIndent());
+    }
+
+    Writer& ArrayPrinter::NextItem() {
+        const PrintContext item_ctx = PrintContext{ writer_, options_ }.Indented();
+        if (!is_empty_) {
+            writer_.Put(',');
+            item_ctx.PrintLineBreak();
+        }
+        is_empty_ = false;
+        item_ctx.PrintIndent();
+        return writer_;
+    }
+
+    int ArrayPrinter::GetItemIndent() const {
+        // Элементы выводятся с тем же отступом, что и внутри PrintValue<Array>
+        return PrintContext{ writer_, options_ }.Indented().indent;
+    }
+
+    void ArrayPrinter::Close() {
+        PrintContext{ writer_, options_ }.PrintLineBreak();
+        writer_.Put(']');
+    }
+
+    void Print(const Document& doc, Writer& writer, const PrintOptions& options) {
+        PrintNode(doc.GetRoot(), PrintContext{ writer, options });
+    }
+
+    void Print(const Node& node, Writer& writer, const PrintOptions& options, int indent) {
+        PrintNode(node, PrintContext{ writer, options, 4, indent });
     }
 
-    void Print(const Document& doc, std::ostream& output) {
-        PrintNode(doc.GetRoot(), PrintContext{ output });
+    void Print(const Document& doc, std::ostream& output, const PrintOptions& options) {
+        Writer writer(output);
+        Print(doc, writer, options);
+        writer.Flush();
     }
 
 }  // namespace json
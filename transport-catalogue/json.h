@@ -1,17 +1,62 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace json {
 
     class Node;
-    using Dict = std::map<std::string, Node>;
     using Array = std::vector<Node>;
 
+    // Словарь на отсортированном по ключам векторе: один блок памяти вместо узла дерева
+    // на каждый ключ и двоичный поиск по непрерывному массиву. Ключи обходятся в том же
+    // порядке, что у std::map, поэтому Print выводит словари как прежде.
+    // Вставка сдвигает хвост, так что большие словари лучше собирать конструктором из вектора
+    class Dict {
+    public:
+        using value_type = std::pair<std::string, Node>;
+        using iterator = std::vector<value_type>::iterator;
+        using const_iterator = std::vector<value_type>::const_iterator;
+
+        Dict() = default;
+        // Элементы сортируются по ключу; из равных ключей остаётся первый
+        explicit Dict(std::vector<value_type> items);
+
+        iterator begin() { return items_.begin(); }
+        iterator end() { return items_.end(); }
+        const_iterator begin() const { return items_.begin(); }
+        const_iterator end() const { return items_.end(); }
+        size_t size() const { return items_.size(); }
+        bool empty() const { return items_.empty(); }
+
+        iterator find(std::string_view key);
+        const_iterator find(std::string_view key) const;
+        size_t count(std::string_view key) const;
+        // std::out_of_range, если ключа нет
+        Node& at(std::string_view key);
+        const Node& at(std::string_view key) const;
+        Node& operator[](std::string key);
+        // Как у std::map: существующее значение не заменяется
+        template <typename Value>
+        std::pair<iterator, bool> emplace(std::string key, Value&& value);
+
+        bool operator==(const Dict& rhs) const;
+        bool operator!=(const Dict& rhs) const { return !(*this == rhs); }
+
+    private:
+        iterator LowerBound(std::string_view key);
+        const_iterator LowerBound(std::string_view key) const;
+
+        std::vector<value_type> items_;
+    };
+
     class ParsingError : public std::runtime_error {
     public:
         using runtime_error::runtime_error;
@@ -136,6 +181,72 @@ namespace json {
         return !(lhs == rhs);
     }
 
+    inline Dict::Dict(std::vector<value_type> items)
+        : items_(std::move(items)) {
+        auto less = [](const value_type& lhs, const value_type& rhs) {
+            return lhs.first < rhs.first;
+        };
+        if (!std::is_sorted(items_.begin(), items_.end(), less)) {
+            std::stable_sort(items_.begin(), items_.end(), less);
+        }
+        items_.erase(std::unique(items_.begin(), items_.end(), [](const value_type& lhs, const value_type& rhs) {
+            return lhs.first == rhs.first;
+            }), items_.end());
+    }
+
+    inline Dict::iterator Dict::LowerBound(std::string_view key) {
+        return std::lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view key) {
+            return item.first < key;
+            });
+    }
+
+    inline Dict::const_iterator Dict::LowerBound(std::string_view key) const {
+        return const_cast<Dict*>(this)->LowerBound(key);
+    }
+
+    inline Dict::iterator Dict::find(std::string_view key) {
+        const auto it = LowerBound(key);
+        return it != items_.end() && it->first == key ? it : items_.end();
+    }
+
+    inline Dict::const_iterator Dict::find(std::string_view key) const {
+        return const_cast<Dict*>(this)->find(key);
+    }
+
+    inline size_t Dict::count(std::string_view key) const {
+        return find(key) != end() ? 1 : 0;
+    }
+
+    inline Node& Dict::at(std::string_view key) {
+        const auto it = find(key);
+        if (it == items_.end()) {
+            using namespace std::literals;
+            throw std::out_of_range("No key '"s + std::string(key) + "' in dict"s);
+        }
+        return it->second;
+    }
+
+    inline const Node& Dict::at(std::string_view key) const {
+        return const_cast<Dict*>(this)->at(key);
+    }
+
+    inline Node& Dict::operator[](std::string key) {
+        return emplace(std::move(key), nullptr).first->second;
+    }
+
+    template <typename Value>
+    std::pair<Dict::iterator, bool> Dict::emplace(std::string key, Value&& value) {
+        const auto it = LowerBound(key);
+        if (it != items_.end() && it->first == key) {
+            return { it, false };
+        }
+        return { items_.emplace(it, std::move(key), Node(std::forward<Value>(value))), true };
+    }
+
+    inline bool Dict::operator==(const Dict& rhs) const {
+        return items_ == rhs.items_;
+    }
+
     class Document {
     public:
         Document() = default;
@@ -159,8 +270,114 @@ namespace json {
         return !(lhs == rhs);
     }
 
+    // Получатель событий потокового разбора: документ целиком не строится,
+    // обработчик сам решает, что из прочитанного сохранить
+    class Handler {
+    public:
+        // Строки ключей и значений действительны только во время вызова
+        virtual void StartDict() = 0;
+        virtual void Key(std::string_view key) = 0;
+        virtual void EndDict() = 0;
+        virtual void StartArray() = 0;
+        virtual void EndArray() = 0;
+        virtual void String(std::string_view value) = 0;
+        // Числа, логические значения и null
+        virtual void Value(Node value) = 0;
+
+    protected:
+        ~Handler() = default;
+    };
+
+    // Разбор текста, уже лежащего в памяти (прочитанного целиком или отображённого файла)
+    Document Load(std::string_view text);
+    // Поток читается порциями по 64 КБ вместе с разбором: кроме документа, в памяти только
+    // порция текста и незаконченный токен
     Document Load(std::istream& input);
 
-    void Print(const Document& doc, std::ostream& output);
+    // Разбор без построения документа: события передаются обработчику по мере чтения
+    void Parse(std::string_view text, Handler& handler);
+    // Память на текст ограничена порцией и самым длинным токеном, а не размером входа
+    void Parse(std::istream& input, Handler& handler);
+
+    // Запись чисел с плавающей точкой при выводе
+    enum class NumberFormat {
+        // Как у std::ostream по умолчанию (%g): precision значащих цифр
+        General,
+        // Кратчайшая запись, которая читается обратно в то же число; precision не используется
+        Shortest,
+        // Ровно precision знаков после точки
+        Fixed
+    };
+
+    struct PrintOptions {
+        NumberFormat number_format = NumberFormat::General;
+        int precision = 6;
+        // Без переводов строк и отступов: документ в одну строку
+        bool compact = false;
+    };
+
+    // Буферизованный вывод JSON: текст копится в большом буфере и уходит в дескриптор
+    // вызовом write(2)/writev (или в поток одним write), когда буфер заполнен, и при Flush
+    class Writer {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = size_t{ 1 } << 20;
+
+        explicit Writer(int fd, size_t capacity = DEFAULT_CAPACITY);
+        explicit Writer(std::ostream& output, size_t capacity = DEFAULT_CAPACITY);
+        // Дописывает текст прямо в конец строки output, без своего буфера:
+        // строку можно очистить и переиспользовать, не создавая новый Writer
+        explicit Writer(std::string& output);
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        // Дописывает остаток буфера; об ошибке записи сообщает только явный Flush
+        ~Writer();
+
+        void Write(std::string_view text);
+        void Put(char c);
+        // Строка в кавычках, с экранированием
+        void WriteString(std::string_view value);
+        void WriteInt(int value);
+        void WriteDouble(double value, const PrintOptions& options = {});
+        // std::system_error при ошибке записи в дескриптор
+        void Flush();
+
+    private:
+        // Отправляет буфер и следом tail
+        void Drain(std::string_view tail = {});
+
+        std::unique_ptr<char[]> buffer_;
+        size_t capacity_;
+        size_t size_ = 0;
+        int fd_ = -1;
+        std::ostream* output_ = nullptr;
+        std::string* text_ = nullptr;
+    };
+
+    // Массив, элементы которого выводятся по мере готовности, без общего json::Array.
+    // Результат тот же, что у Print для массива из тех же элементов
+    class ArrayPrinter {
+    public:
+        // Сразу выводит открывающую скобку
+        explicit ArrayPrinter(Writer& writer, const PrintOptions& options = {});
+
+        void Add(const Node& item);
+        // Начинает элемент, который вызывающий выводит сам (например, StreamBuilder)
+        // с отступом GetItemIndent()
+        Writer& NextItem();
+        int GetItemIndent() const;
+        const PrintOptions& GetOptions() const { return options_; }
+        // Выводит закрывающую скобку
+        void Close();
+
+    private:
+        Writer& writer_;
+        PrintOptions options_;
+        bool is_empty_ = true;
+    };
+
+    void Print(const Document& doc, Writer& writer, const PrintOptions& options = {});
+    // Узел, вложенный в выводимый документ: indent — отступ строки, на которой он начат
+    void Print(const Node& node, Writer& writer, const PrintOptions& options, int indent);
+    void Print(const Document& doc, std::ostream& output, const PrintOptions& options = {});
 
 }  // namespace json
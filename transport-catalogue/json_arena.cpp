@@ -0,0 +1,214 @@
+#include "json_arena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <variant>
+
+using namespace std::literals;
+
+namespace json
+{
+    const ArenaNode* ArenaDict::find(std::string_view key) const
+    {
+        const auto it = std::lower_bound(begin(), end(), key, [](const ArenaMember& member, std::string_view key) {
+            return member.key < key;
+            });
+        return it != end() && it->key == key ? &it->value : nullptr;
+    }
+
+    const ArenaNode& ArenaDict::at(std::string_view key) const
+    {
+        const ArenaNode* node = find(key);
+        if (!node) {
+            throw std::out_of_range("No key '"s + std::string(key) + "' in dict"s);
+        }
+        return *node;
+    }
+
+    ArenaBuilder::ArenaBuilder(std::pmr::memory_resource* arena, std::string_view retained_text)
+        : arena_(arena), retained_text_(retained_text)
+    {
+    }
+
+    void ArenaBuilder::StartDict()
+    {
+        open_containers_.push_back({ true, members_.size() });
+    }
+
+    void ArenaBuilder::Key(std::string_view key)
+    {
+        keys_.push_back(Store(key));
+    }
+
+    void ArenaBuilder::EndDict()
+    {
+        const size_t first = open_containers_.back().begin;
+        const auto begin = members_.begin() + first;
+        open_containers_.pop_back();
+        std::sort(begin, members_.end(), [](const ArenaMember& lhs, const ArenaMember& rhs) {
+            return lhs.key < rhs.key;
+            });
+        const auto duplicate = std::adjacent_find(begin, members_.end(), [](const ArenaMember& lhs, const ArenaMember& rhs) {
+            return lhs.key == rhs.key;
+            });
+        if (duplicate != members_.end()) {
+            throw ParsingError("Duplicate key '"s + std::string(duplicate->key) + "' have been found");
+        }
+
+        ArenaNode node;
+        node.type_ = ArenaNode::Type::Dict;
+        node.size_ = CheckSize(members_.end() - begin);
+        // У пустого словаря begin — конец вектора, его нельзя разыменовать
+        node.members_ = CopyToArena(members_.data() + first, node.size_);
+        members_.erase(begin, members_.end());
+        Add(node);
+    }
+
+    void ArenaBuilder::StartArray()
+    {
+        open_containers_.push_back({ false, values_.size() });
+    }
+
+    void ArenaBuilder::EndArray()
+    {
+        const size_t begin = open_containers_.back().begin;
+        open_containers_.pop_back();
+
+        ArenaNode node;
+        node.type_ = ArenaNode::Type::Array;
+        node.size_ = CheckSize(values_.size() - begin);
+        node.items_ = CopyToArena(values_.data() + begin, node.size_);
+        values_.resize(begin);
+        Add(node);
+    }
+
+    void ArenaBuilder::String(std::string_view value)
+    {
+        const std::string_view stored = Store(value);
+        ArenaNode node;
+        node.type_ = ArenaNode::Type::String;
+        node.size_ = CheckSize(stored.size());
+        node.chars_ = stored.data();
+        Add(node);
+    }
+
+    void ArenaBuilder::Value(const Node& value)
+    {
+        ArenaNode node;
+        if (value.IsBool()) {
+            node.type_ = ArenaNode::Type::Bool;
+            node.bool_ = value.AsBool();
+        }
+        else if (value.IsInt()) {
+            node.type_ = ArenaNode::Type::Int;
+            node.int_ = value.AsInt();
+        }
+        else if (value.IsPureDouble()) {
+            node.type_ = ArenaNode::Type::Double;
+            node.double_ = value.AsDouble();
+        }
+        else if (value.IsString()) {
+            String(value.AsString());
+            return;
+        }
+        else if (!value.IsNull()) {
+            throw std::logic_error("Containers are built with Start/End calls"s);
+        }
+        Add(node);
+    }
+
+    void ArenaBuilder::Reset()
+    {
+        root_ = ArenaNode{};
+        open_containers_.clear();
+        values_.clear();
+        members_.clear();
+        keys_.clear();
+    }
+
+    void ArenaBuilder::Add(const ArenaNode& node)
+    {
+        if (open_containers_.empty()) {
+            root_ = node;
+        }
+        else if (!open_containers_.back().is_dict) {
+            values_.push_back(node);
+        }
+        else {
+            members_.push_back({ keys_.back(), node });
+            keys_.pop_back();
+        }
+    }
+
+    std::string_view ArenaBuilder::Store(std::string_view text)
+    {
+        // Сравнение указателей через uintptr_t: строка может лежать вне retained_text_
+        const auto address = reinterpret_cast<std::uintptr_t>(text.data());
+        const auto retained_begin = reinterpret_cast<std::uintptr_t>(retained_text_.data());
+        if (address >= retained_begin && address + text.size() <= retained_begin + retained_text_.size()
+            && !retained_text_.empty()) {
+            return text;
+        }
+        if (text.empty()) {
+            return {};
+        }
+        char* chars = static_cast<char*>(arena_->allocate(text.size(), 1));
+        std::memcpy(chars, text.data(), text.size());
+        return { chars, text.size() };
+    }
+
+    template <typename T>
+    const T* ArenaBuilder::CopyToArena(const T* items, size_t size)
+    {
+        if (size == 0) {
+            return nullptr;
+        }
+        T* copy = static_cast<T*>(arena_->allocate(size * sizeof(T), alignof(T)));
+        std::uninitialized_copy(items, items + size, copy);
+        return copy;
+    }
+
+    std::uint32_t ArenaBuilder::CheckSize(size_t size)
+    {
+        if (size > std::numeric_limits<std::uint32_t>::max()) {
+            throw ParsingError("Value is too large for an arena document"s);
+        }
+        return static_cast<std::uint32_t>(size);
+    }
+
+    Node ToNode(const ArenaNode& node)
+    {
+        if (node.IsMap()) {
+            // Пары уже отсортированы по ключу, Dict их не пересортировывает
+            std::vector<Dict::value_type> items;
+            items.reserve(node.AsMap().size());
+            for (const auto& [key, value] : node.AsMap()) {
+                items.emplace_back(std::string(key), ToNode(value));
+            }
+            return Node(Dict(std::move(items)));
+        }
+        if (node.IsArray()) {
+            Array array;
+            array.reserve(node.AsArray().size());
+            for (const auto& item : node.AsArray()) {
+                array.push_back(ToNode(item));
+            }
+            return Node(std::move(array));
+        }
+        if (node.IsString()) {
+            return Node(std::string(node.AsString()));
+        }
+        if (node.IsInt()) {
+            return Node(node.AsInt());
+        }
+        if (node.IsPureDouble()) {
+            return Node(node.AsDouble());
+        }
+        if (node.IsBool()) {
+            return Node(node.AsBool());
+        }
+        return Node();
+    }
+
+}
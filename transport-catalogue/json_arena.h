@@ -0,0 +1,192 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+    class ArenaDict;
+    struct ArenaMember;
+
+    // Непрерывный диапазон элементов в арене
+    template <typename T>
+    class ArenaRange {
+    public:
+        ArenaRange(const T* items, size_t size)
+            : items_(items)
+            , size_(size) {
+        }
+
+        const T* begin() const { return items_; }
+        const T* end() const { return items_ + size_; }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        const T& operator[](size_t index) const { return items_[index]; }
+
+    private:
+        const T* items_;
+        size_t size_;
+    };
+
+    // Узел документа, целиком лежащего в арене: 16 байт без собственных выделений памяти.
+    // Строки без экранирования указывают прямо во входной текст, остальные скопированы в арену.
+    // Узел только для чтения и живёт, пока жив его документ (или арена построителя)
+    class ArenaNode {
+    public:
+        ArenaNode() = default;
+
+        bool IsNull() const { return type_ == Type::Null; }
+        bool IsBool() const { return type_ == Type::Bool; }
+        bool IsInt() const { return type_ == Type::Int; }
+        bool IsPureDouble() const { return type_ == Type::Double; }
+        bool IsDouble() const { return IsInt() || IsPureDouble(); }
+        bool IsString() const { return type_ == Type::String; }
+        bool IsArray() const { return type_ == Type::Array; }
+        bool IsMap() const { return type_ == Type::Dict; }
+
+        bool AsBool() const {
+            Check(IsBool(), "Not a bool");
+            return bool_;
+        }
+        int AsInt() const {
+            Check(IsInt(), "Not an int");
+            return int_;
+        }
+        double AsDouble() const {
+            Check(IsDouble(), "Not a double");
+            return IsPureDouble() ? double_ : int_;
+        }
+        std::string_view AsString() const {
+            Check(IsString(), "Not a string");
+            return { chars_, size_ };
+        }
+        ArenaRange<ArenaNode> AsArray() const {
+            Check(IsArray(), "Not an array");
+            return { items_, size_ };
+        }
+        ArenaDict AsMap() const;
+
+    private:
+        friend class ArenaBuilder;
+
+        enum class Type : std::uint8_t {
+            Null,
+            Bool,
+            Int,
+            Double,
+            String,
+            Array,
+            Dict
+        };
+
+        static void Check(bool condition, const char* message) {
+            if (!condition) {
+                throw std::logic_error(message);
+            }
+        }
+
+        Type type_ = Type::Null;
+        std::uint32_t size_ = 0;
+        union {
+            bool bool_;
+            int int_;
+            double double_;
+            const char* chars_;
+            const ArenaNode* items_;
+            const ArenaMember* members_ = nullptr;
+        };
+    };
+
+    struct ArenaMember {
+        std::string_view key;
+        ArenaNode value;
+    };
+
+    // Пары словаря отсортированы по ключу, как в Dict
+    class ArenaDict : public ArenaRange<ArenaMember> {
+    public:
+        using ArenaRange::ArenaRange;
+
+        // nullptr, если ключа нет
+        const ArenaNode* find(std::string_view key) const;
+        // std::out_of_range, если ключа нет
+        const ArenaNode& at(std::string_view key) const;
+    };
+
+    inline ArenaDict ArenaNode::AsMap() const {
+        Check(IsMap(), "Not a dict");
+        return { members_, size_ };
+    }
+
+    // Собирает узлы из событий разбора в арену. Элементы открытых контейнеров копятся
+    // в общих стеках и при закрытии контейнера переносятся в арену одним куском.
+    // Строки из retained_text не копируются: на них ссылаются узлы
+    class ArenaBuilder {
+    public:
+        explicit ArenaBuilder(std::pmr::memory_resource* arena, std::string_view retained_text = {});
+
+        void StartDict();
+        void Key(std::string_view key);
+        void EndDict();
+        void StartArray();
+        void EndArray();
+        void String(std::string_view value);
+        // null, bool, int или double
+        void Value(const Node& value);
+
+        const ArenaNode& GetRoot() const { return root_; }
+        // Готовит построитель к следующему документу; память арены освобождает её владелец
+        void Reset();
+
+    private:
+        struct OpenContainer {
+            bool is_dict;
+            // Начало элементов контейнера в members_ или values_
+            size_t begin;
+        };
+
+        void Add(const ArenaNode& node);
+        std::string_view Store(std::string_view text);
+        template <typename T>
+        const T* CopyToArena(const T* items, size_t size);
+        static std::uint32_t CheckSize(size_t size);
+
+        std::pmr::memory_resource* arena_;
+        std::string_view retained_text_;
+        ArenaNode root_;
+        std::vector<OpenContainer> open_containers_;
+        std::vector<ArenaNode> values_;
+        std::vector<ArenaMember> members_;
+        std::vector<std::string_view> keys_;
+    };
+
+    // Документ в арене: входной текст и несколько крупных блоков памяти под все узлы.
+    // Уничтожение документа — освобождение этих блоков, а не каждого узла
+    class ArenaDocument {
+    public:
+        const ArenaNode& GetRoot() const { return root_; }
+
+    private:
+        friend ArenaDocument LoadArena(std::string text);
+
+        // Текст и арена лежат в куче, чтобы строки узлов не смещались при перемещении документа
+        std::unique_ptr<const std::string> text_;
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+        ArenaNode root_;
+    };
+
+    // Разбор в арену; текст переходит во владение документа
+    ArenaDocument LoadArena(std::string text);
+    ArenaDocument LoadArena(std::istream& input);
+
+    // Копия узла в обычный Node — для частей документа, которые нужны дольше арены
+    Node ToNode(const ArenaNode& node);
+
+} // namespace json
@@ -102,5 +102,211 @@ namespace json
         }
     }
 
+    StreamBuilder::StreamBuilder(Writer& writer, const PrintOptions& options, int indent)
+        : writer_(writer), options_(options), indent_(indent)
+    {
+    }
+
+    StreamBuilder::StreamBuilder(ArrayPrinter& array)
+        : StreamBuilder(array.NextItem(), array.GetOptions(), array.GetItemIndent())
+    {
+    }
+
+    StreamBuilder::KeyContext StreamBuilder::Key(std::string_view key)
+    {
+        if (depth_ == 0 && is_complete_) {
+            throw std::logic_error("Attempt to change finalized JSON"s);
+        }
+        if (depth_ == 0 || !GetFrame(depth_ - 1).is_dict || GetFrame(depth_ - 1).has_key) {
+            throw std::logic_error("Key() outside a dict"s);
+        }
+        Frame& frame = GetFrame(depth_ - 1);
+        if (!frame.is_empty) {
+            if (key <= frame.last_key) {
+                throw std::logic_error("Key '"s + std::string(key) + "' is not greater than the previous key '"s + frame.last_key + "'"s);
+            }
+            writer_.Put(',');
+            WriteLineBreak();
+        }
+        frame.is_empty = false;
+        frame.has_key = true;
+        frame.last_key.assign(key);
+        WriteIndent(depth_);
+        writer_.WriteString(key);
+        writer_.Write(options_.compact ? ":"sv : ": "sv);
+        return KeyContext(*this);
+    }
+
+    StreamBuilder::Context StreamBuilder::Value(std::nullptr_t)
+    {
+        BeforeValue();
+        writer_.Write("null"sv);
+        AfterValue();
+        return Context(*this);
+    }
+
+    StreamBuilder::Context StreamBuilder::Value(bool value)
+    {
+        BeforeValue();
+        writer_.Write(value ? "true"sv : "false"sv);
+        AfterValue();
+        return Context(*this);
+    }
+
+    StreamBuilder::Context StreamBuilder::Value(int value)
+    {
+        BeforeValue();
+        writer_.WriteInt(value);
+        AfterValue();
+        return Context(*this);
+    }
+
+    StreamBuilder::Context StreamBuilder::Value(double value)
+    {
+        BeforeValue();
+        writer_.WriteDouble(value, options_);
+        AfterValue();
+        return Context(*this);
+    }
+
+    StreamBuilder::Context StreamBuilder::Value(std::string_view value)
+    {
+        BeforeValue();
+        writer_.WriteString(value);
+        AfterValue();
+        return Context(*this);
+    }
+
+    StreamBuilder::Context StreamBuilder::Value(const std::string& value)
+    {
+        return Value(std::string_view(value));
+    }
+
+    StreamBuilder::Context StreamBuilder::Value(const char* value)
+    {
+        return Value(std::string_view(value));
+    }
+
+    StreamBuilder::Context StreamBuilder::Value(const Node& value)
+    {
+        BeforeValue();
+        Print(value, writer_, options_, GetValueIndent());
+        AfterValue();
+        return Context(*this);
+    }
+
+    StreamBuilder::Context StreamBuilder::RawValue(std::string_view text)
+    {
+        BeforeValue();
+        writer_.Write(text);
+        AfterValue();
+        return Context(*this);
+    }
+
+    StreamBuilder::DictContext StreamBuilder::StartDict()
+    {
+        StartContainer(true);
+        return DictContext(*this);
+    }
+
+    StreamBuilder::ArrayContext StreamBuilder::StartArray()
+    {
+        StartContainer(false);
+        return ArrayContext(*this);
+    }
+
+    StreamBuilder& StreamBuilder::EndDict()
+    {
+        EndContainer(true);
+        return *this;
+    }
+
+    StreamBuilder& StreamBuilder::EndArray()
+    {
+        EndContainer(false);
+        return *this;
+    }
+
+    void StreamBuilder::Build()
+    {
+        if (!is_complete_) {
+            throw std::logic_error("Attempt to build incomplete JSON"s);
+        }
+    }
+
+    void StreamBuilder::BeforeValue()
+    {
+        if (depth_ == 0) {
+            if (is_complete_) {
+                throw std::logic_error("Attempt to change finalized JSON"s);
+            }
+            return;
+        }
+        Frame& frame = GetFrame(depth_ - 1);
+        if (frame.is_dict) {
+            if (!frame.has_key) {
+                throw std::logic_error("New object in wrong context"s);
+            }
+            frame.has_key = false;
+            return;
+        }
+        if (!frame.is_empty) {
+            writer_.Put(',');
+            WriteLineBreak();
+        }
+        frame.is_empty = false;
+        WriteIndent(depth_);
+    }
+
+    void StreamBuilder::AfterValue()
+    {
+        if (depth_ == 0) {
+            is_complete_ = true;
+        }
+    }
+
+    void StreamBuilder::StartContainer(bool is_dict)
+    {
+        BeforeValue();
+        writer_.Put(is_dict ? '{' : '[');
+        WriteLineBreak();
+        if (depth_ >= inline_frames_.size() && depth_ - inline_frames_.size() == extra_frames_.size()) {
+            extra_frames_.emplace_back();
+        }
+        Frame& frame = GetFrame(depth_++);
+        frame.is_dict = is_dict;
+        frame.is_empty = true;
+        frame.has_key = false;
+    }
+
+    void StreamBuilder::EndContainer(bool is_dict)
+    {
+        if (depth_ == 0 || GetFrame(depth_ - 1).is_dict != is_dict || GetFrame(depth_ - 1).has_key) {
+            throw std::logic_error(is_dict ? "EndDict() outside a dict"s : "EndArray() outside an array"s);
+        }
+        --depth_;
+        WriteLineBreak();
+        WriteIndent(depth_);
+        writer_.Put(is_dict ? '}' : ']');
+        AfterValue();
+    }
+
+    void StreamBuilder::WriteLineBreak()
+    {
+        if (!options_.compact) {
+            writer_.Put('\n');
+        }
+    }
+
+    void StreamBuilder::WriteIndent(size_t depth)
+    {
+        if (options_.compact) {
+            return;
+        }
+        const int indent = indent_ + INDENT_STEP * static_cast<int>(depth);
+        for (int i = 0; i < indent; ++i) {
+            writer_.Put(' ');
+        }
+    }
 
 }
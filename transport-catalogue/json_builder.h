@@ -1,8 +1,11 @@
 #pragma once
+#include <array>
 #include <vector>
 #include <string>
 #include <stdexcept>
 #include <optional>
+#include <string_view>
+#include <utility>
 #include "json.h"
 
 namespace json {
@@ -123,4 +126,167 @@ namespace json {
         void AddObject(Node::Value value, bool one_shot);
     };
 
+    // Построитель с тем же интерфейсом, что у Builder, но без дерева Node: значения сразу
+    // выводятся в Writer в формате Print. Словарь выводится в порядке вызовов Key, поэтому
+    // ключи должны идти по возрастанию — так, как их упорядочил бы Dict
+    class StreamBuilder
+    {
+    public:
+        class Context;
+        class KeyContext;
+        class DictContext;
+        class ArrayContext;
+
+        // indent — отступ строки, на которой начато значение
+        explicit StreamBuilder(Writer& writer, const PrintOptions& options = {}, int indent = 0);
+        // Очередной элемент потокового массива
+        explicit StreamBuilder(ArrayPrinter& array);
+
+        class Context
+        {
+        public:
+            explicit Context(StreamBuilder& builder) : builder_(builder) {};
+            KeyContext Key(std::string_view key)
+            {
+                return builder_.Key(key);
+            }
+            DictContext StartDict()
+            {
+                return builder_.StartDict();
+            }
+            StreamBuilder& EndDict()
+            {
+                return builder_.EndDict();
+            }
+            ArrayContext StartArray()
+            {
+                return builder_.StartArray();
+            }
+            StreamBuilder& EndArray()
+            {
+                return builder_.EndArray();
+            }
+            void Build()
+            {
+                builder_.Build();
+            }
+
+        protected:
+            StreamBuilder& builder_;
+        };
+
+        class DictContext : public Context
+        {
+        public:
+            using Context::Context;
+
+            DictContext StartDict() = delete;
+            ArrayContext StartArray() = delete;
+            StreamBuilder& EndArray() = delete;
+            void Build() = delete;
+        };
+
+        class KeyContext : public Context
+        {
+        public:
+            using Context::Context;
+
+            template <typename T>
+            DictContext Value(T&& value)
+            {
+                builder_.Value(std::forward<T>(value));
+                return DictContext(builder_);
+            }
+            DictContext RawValue(std::string_view text)
+            {
+                builder_.RawValue(text);
+                return DictContext(builder_);
+            }
+
+            KeyContext Key(std::string_view key) = delete;
+            StreamBuilder& EndDict() = delete;
+            StreamBuilder& EndArray() = delete;
+            void Build() = delete;
+        };
+
+        class ArrayContext : public Context
+        {
+        public:
+            using Context::Context;
+
+            template <typename T>
+            ArrayContext Value(T&& value)
+            {
+                builder_.Value(std::forward<T>(value));
+                return ArrayContext(builder_);
+            }
+            ArrayContext RawValue(std::string_view text)
+            {
+                builder_.RawValue(text);
+                return ArrayContext(builder_);
+            }
+
+            KeyContext Key(std::string_view key) = delete;
+            StreamBuilder& EndDict() = delete;
+            void Build() = delete;
+        };
+
+        KeyContext Key(std::string_view key);
+        Context Value(std::nullptr_t);
+        Context Value(bool value);
+        Context Value(int value);
+        Context Value(double value);
+        Context Value(std::string_view value);
+        Context Value(const std::string& value);
+        Context Value(const char* value);
+        // Готовый узел, в том числе словарь или массив
+        Context Value(const Node& value);
+        // Значение, уже выведенное в текст другим построителем с теми же GetOptions()
+        // и отступом GetValueIndent(); текст копируется в вывод как есть
+        Context RawValue(std::string_view text);
+        DictContext StartDict();
+        ArrayContext StartArray();
+        StreamBuilder& EndDict();
+        StreamBuilder& EndArray();
+        // Проверяет, что значение выведено целиком
+        void Build();
+
+        const PrintOptions& GetOptions() const { return options_; }
+        // Отступ строки, на которой начнётся очередное значение
+        int GetValueIndent() const { return indent_ + INDENT_STEP * static_cast<int>(depth_); }
+
+    private:
+        static constexpr int INDENT_STEP = 4;
+
+        struct Frame
+        {
+            bool is_dict = false;
+            bool is_empty = true;
+            bool has_key = false;
+            // Строка переиспользуется вложенными контейнерами той же глубины
+            std::string last_key;
+        };
+
+        Frame& GetFrame(size_t depth)
+        {
+            return depth < inline_frames_.size() ? inline_frames_[depth] : extra_frames_[depth - inline_frames_.size()];
+        }
+        void BeforeValue();
+        void AfterValue();
+        void StartContainer(bool is_dict);
+        void EndContainer(bool is_dict);
+        void WriteLineBreak();
+        void WriteIndent(size_t depth);
+
+        Writer& writer_;
+        PrintOptions options_;
+        int indent_;
+        // Кадры первых уровней лежат в самом построителе, так что ответ обычной глубины
+        // с короткими ключами строится без выделения памяти
+        std::array<Frame, 8> inline_frames_;
+        std::vector<Frame> extra_frames_;
+        size_t depth_ = 0;
+        bool is_complete_ = false;
+    };
+
 } // namespace json
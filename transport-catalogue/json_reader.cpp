@@ -1,11 +1,386 @@
 #include "json_reader.h"
+#include "json_arena.h"
 #include "json_builder.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory_resource>
+
+namespace
+{
+    // Ключи выводятся по возрастанию, как их упорядочил бы Dict
+    void WriteRouteItem(json::StreamBuilder& builder, const RouteItem& item)
+    {
+        builder.StartDict();
+        if (item.type == RouteItem::ItemType::Wait)
+        {
+            builder.Key("stop_name").Value(item.name)
+                .Key("time").Value(item.time)
+                .Key("type").Value("Wait");
+        }
+        else
+        {
+            builder.Key("bus").Value(item.name)
+                .Key("span_count").Value(static_cast<int>(item.span_count))
+                .Key("time").Value(item.time)
+                .Key("type").Value("Bus");
+        }
+        builder.EndDict();
+    }
+
+    // Ключи ответа из готового текста кеша: request_id встаёт между ними по порядку
+    void WriteCachedRoute(json::StreamBuilder& builder, const CachedRoute& route, int id)
+    {
+        if (route.items.empty())
+        {
+            builder.Key("error_message").Value("not found")
+                .Key("request_id").Value(id);
+        }
+        else
+        {
+            builder.Key("items").RawValue(route.items)
+                .Key("request_id").Value(id)
+                .Key("total_time").RawValue(route.total_time);
+        }
+    }
+
+    // Начальные остановки для прогрева роутера: явный список routing_settings.warmup_stops
+    // и самые частые "from" из записанного журнала запросов warmup_requests
+    std::vector<std::string> CollectWarmUpOrigins(const json::Dict& routing_settings, const json::Dict& root)
+    {
+        std::vector<std::string> origins;
+        if (const auto it = routing_settings.find("warmup_stops"); it != routing_settings.end())
+        {
+            for (const auto& stop : it->second.AsArray())
+            {
+                origins.push_back(stop.AsString());
+            }
+        }
+
+        const auto requests_it = root.find("warmup_requests");
+        if (requests_it == root.end())
+        {
+            return origins;
+        }
+        std::map<std::string_view, size_t> origin_counts;
+        for (const auto& request : requests_it->second.AsArray())
+        {
+            const auto& request_map = request.AsMap();
+            if (request_map.at("type").AsString() == "Route")
+            {
+                ++origin_counts[request_map.at("from").AsString()];
+            }
+        }
+        std::vector<std::pair<size_t, std::string_view>> frequent_origins;
+        for (const auto& [stop, count] : origin_counts)
+        {
+            frequent_origins.push_back({ count, stop });
+        }
+        std::sort(frequent_origins.begin(), frequent_origins.end(), [](const auto& lhs, const auto& rhs)
+        {
+            return lhs.first != rhs.first ? lhs.first > rhs.first : lhs.second < rhs.second;
+        });
+
+        size_t limit = 64;
+        if (const auto it = routing_settings.find("warmup_origin_limit"); it != routing_settings.end())
+        {
+            limit = static_cast<size_t>(std::max(it->second.AsInt(), 0));
+        }
+        for (size_t i = 0; i < frequent_origins.size() && i < limit; ++i)
+        {
+            origins.emplace_back(frequent_origins[i].second);
+        }
+        return origins;
+    }
+
+    // Наибольшая задержка готового ответа в буфере вывода
+    constexpr auto STREAM_FLUSH_INTERVAL = std::chrono::milliseconds(50);
+    std::optional<int> FindRequestId(const json::Dict& request)
+    {
+        if (const auto it = request.find("id"); it != request.end() && it->second.IsInt())
+        {
+            return it->second.AsInt();
+        }
+        return std::nullopt;
+    }
+
+    // Ответ на запрос, обработка которого упала: описание ошибки вместо результата
+    void WriteErrorResponse(json::StreamBuilder& builder, const char* message, std::optional<int> id)
+    {
+        builder.StartDict().Key("error_message").Value(message);
+        if (id)
+        {
+            builder.Key("request_id").Value(*id);
+        }
+        builder.EndDict();
+    }
+
+    // Запись чисел в ответе из необязательного раздела output_settings:
+    // "number_format" — "general" (по умолчанию), "shortest" или "fixed", "precision" — точность
+    json::PrintOptions ReadPrintOptions(const json::Dict& root)
+    {
+        json::PrintOptions options;
+        const auto settings_it = root.find("output_settings");
+        if (settings_it == root.end())
+        {
+            return options;
+        }
+        const auto& settings = settings_it->second.AsMap();
+        if (const auto it = settings.find("number_format"); it != settings.end())
+        {
+            const auto& format = it->second.AsString();
+            if (format == "shortest")
+            {
+                options.number_format = json::NumberFormat::Shortest;
+            }
+            else if (format == "fixed")
+            {
+                options.number_format = json::NumberFormat::Fixed;
+            }
+            else if (format != "general")
+            {
+                throw std::invalid_argument("Unknown number_format: " + format);
+            }
+        }
+        if (const auto it = settings.find("precision"); it != settings.end())
+        {
+            options.precision = std::clamp(it->second.AsInt(), 0, 17);
+        }
+        return options;
+    }
+}
+
+class InformationProcessing::InputHandler final : public json::Handler
+{
+public:
+    explicit InputHandler(InformationProcessing& processing)
+        : processing_(processing), arena_(arena_buffer_, sizeof(arena_buffer_)), request_(&arena_)
+    {
+    }
+
+    void StartDict() override
+    {
+        ++depth_;
+        if (is_base_requests_)
+        {
+            request_.StartDict();
+        }
+        else
+        {
+            root_.StartDict();
+        }
+    }
+
+    void Key(std::string_view key) override
+    {
+        if (depth_ == 1 && key == "base_requests")
+        {
+            is_base_requests_key_ = true;
+        }
+        else if (is_base_requests_)
+        {
+            request_.Key(key);
+        }
+        else
+        {
+            root_.Key(std::string(key));
+        }
+    }
+
+    void EndDict() override
+    {
+        --depth_;
+        if (!is_base_requests_)
+        {
+            root_.EndDict();
+            return;
+        }
+        request_.EndDict();
+        if (depth_ == 2)
+        {
+            // Элемент внесён в каталог, его память в арене больше не нужна
+            processing_.ProcessBaseRequest(request_.GetRoot().AsMap());
+            request_.Reset();
+            arena_.release();
+        }
+    }
+
+    void StartArray() override
+    {
+        ++depth_;
+        if (is_base_requests_key_)
+        {
+            is_base_requests_key_ = false;
+            is_base_requests_ = true;
+        }
+        else if (is_base_requests_)
+        {
+            request_.StartArray();
+        }
+        else
+        {
+            root_.StartArray();
+        }
+    }
+
+    void EndArray() override
+    {
+        --depth_;
+        if (is_base_requests_ && depth_ == 1)
+        {
+            is_base_requests_ = false;
+        }
+        else if (is_base_requests_)
+        {
+            request_.EndArray();
+        }
+        else
+        {
+            root_.EndArray();
+        }
+    }
+
+    void String(std::string_view value) override
+    {
+        CheckBaseRequestsValue();
+        if (is_base_requests_)
+        {
+            request_.String(value);
+        }
+        else
+        {
+            root_.Value(std::string(value));
+        }
+    }
+
+    void Value(json::Node value) override
+    {
+        CheckBaseRequestsValue();
+        if (is_base_requests_)
+        {
+            request_.Value(value);
+        }
+        else
+        {
+            root_.Value(std::move(value.GetValue()));
+        }
+    }
+
+    json::Node GetRoot()
+    {
+        return root_.Build();
+    }
+
+private:
+    void CheckBaseRequestsValue() const
+    {
+        if (is_base_requests_key_ || (is_base_requests_ && depth_ == 2))
+        {
+            throw json::ParsingError("base_requests should be an array of dicts");
+        }
+    }
+
+    InformationProcessing& processing_;
+    // Всё, кроме base_requests
+    json::Builder root_;
+    // Текущий элемент base_requests собирается в арене, которая освобождается после каждого
+    // элемента: пока элемент умещается в буфер, разбор base_requests не выделяет памяти под узлы
+    alignas(std::max_align_t) char arena_buffer_[16 * 1024];
+    std::pmr::monotonic_buffer_resource arena_;
+    json::ArenaBuilder request_;
+    size_t depth_ = 0;
+    bool is_base_requests_key_ = false;
+    bool is_base_requests_ = false;
+};
+
 InformationProcessing::InformationProcessing(TransportCatalogue& catalogue, std::istream& input_stream_, std::ostream& out_)
-    : catalogue_(catalogue), input_stream(input_stream_), out(out_)
+    : catalogue_(catalogue), out(out_)
+{
+    InputHandler handler(*this);
+    json::Parse(input_stream_, handler);
+    FinishBaseRequests();
+    root = handler.GetRoot();
+}
+
+InformationProcessing::InformationProcessing(TransportCatalogue& catalogue, std::string document_text, std::ostream& out_)
+    : catalogue_(catalogue), out(out_)
+{
+    const json::ArenaDocument document = json::LoadArena(std::move(document_text));
+    std::vector<json::Dict::value_type> sections;
+    for (const auto& [key, value] : document.GetRoot().AsMap())
+    {
+        if (key != "base_requests")
+        {
+            sections.emplace_back(std::string(key), json::ToNode(value));
+            continue;
+        }
+        if (!value.IsArray())
+        {
+            throw json::ParsingError("base_requests should be an array of dicts");
+        }
+        for (const auto& request : value.AsArray())
+        {
+            if (!request.IsMap())
+            {
+                throw json::ParsingError("base_requests should be an array of dicts");
+            }
+            ProcessBaseRequest(request.AsMap());
+        }
+    }
+    FinishBaseRequests();
+    root = json::Node(json::Dict(std::move(sections)));
+}
+
+void InformationProcessing::ProcessBaseRequest(const json::ArenaDict& request)
+{
+    const auto type = request.at("type").AsString();
+    if (type == "Stop")
+    {
+        const std::string name(request.at("name").AsString());
+        catalogue_.AddStop(name, { request.at("latitude").AsDouble(), request.at("longitude").AsDouble() });
+        Stop* stop = catalogue_.FindStop(name);
+        for (const auto& [stop_name, distance_node] : request.at("road_distances").AsMap())
+        {
+            if (Stop* other_stop = catalogue_.FindStop(stop_name))
+            {
+                catalogue_.AddDistance(stop, other_stop, distance_node.AsInt());
+            }
+            else
+            {
+                pending_distances_.push_back({ stop, std::string(stop_name), distance_node.AsInt() });
+            }
+        }
+    }
+    else if (type == "Bus")
+    {
+        // Порядок автобусов в каталоге тот же, что при разборе документа целиком
+        PendingBus bus{ std::string(request.at("name").AsString()), {}, request.at("is_roundtrip").AsBool() };
+        for (const auto& stop_node : request.at("stops").AsArray())
+        {
+            bus.stops.emplace_back(stop_node.AsString());
+        }
+        pending_buses_.push_back(std::move(bus));
+    }
+}
+
+void InformationProcessing::FinishBaseRequests()
 {
-    doc = json::Load(input_stream);
-    root = doc.GetRoot();
+    // Расстояния до остановок, так и не встреченных во входе, пропускаются, как и раньше
+    for (const auto& [from, to, distance] : pending_distances_)
+    {
+        if (Stop* other_stop = catalogue_.FindStop(to))
+        {
+            catalogue_.AddDistance(from, other_stop, distance);
+        }
+    }
+    for (const auto& bus : pending_buses_)
+    {
+        AddBus(bus.name, std::vector<std::string_view>(bus.stops.begin(), bus.stops.end()), bus.is_roundtrip);
+    }
+    pending_distances_ = {};
+    pending_buses_ = {};
 }
 
 void InformationProcessing::ProcessBaseRequests(const json::Array& base_requests)
@@ -71,6 +446,16 @@ svg::Color InformationProcessing::ProcessColor(const json::Node& color_node)
     throw std::logic_error("Invalid color format");
 }
 
+void InformationProcessing::RenderMap()
+{
+    os.str({});
+    svg::Document svg_doc;
+    MapRenderer mr(set);
+    mr.RenderStopsAndBuses(catalogue_, svg_doc);
+    svg_doc.Render(os);
+    is_map_outdated_ = false;
+}
+
 void InformationProcessing::ProcessStop(const json::Dict& stop_data)
 {
     const std::string& name = stop_data.at("name").AsString();
@@ -107,6 +492,11 @@ void InformationProcessing::ProcessBus(const json::Dict& bus_data)
     {
         stops.push_back(stop_node.AsString());
     }
+    AddBus(name, std::move(stops), is_roundtrip);
+}
+
+void InformationProcessing::AddBus(const std::string& name, std::vector<std::string_view> stops, bool is_roundtrip)
+{
     if (!is_roundtrip)
     {
         // Для некольцевого маршрута (A-B-C-D) - [A,B,C,D,C,B,A]
@@ -123,30 +513,165 @@ void InformationProcessing::ProcessBus(const json::Dict& bus_data)
 
 void InformationProcessing::ProcessStatRequests(const json::Array& stat_requests)
 {
-    json::Array response_array;
+    std::optional<json::Writer> writer;
+    OpenOutput(writer);
+    // Каждый ответ выводится в буфер по мере построения, без промежуточных узлов,
+    // и готовые можно читать, пока считаются следующие
+    json::ArrayPrinter responses(*writer, ReadPrintOptions(root.AsMap()));
+    auto last_flush = std::chrono::steady_clock::now();
+    // Текст в кеше маршрутов выведен в формате ответов, с которым был получен
+    route_cache_.Clear();
 
+    // Ответ собирается отдельно и попадает в массив только целиком: запрос, упавший на середине,
+    // не оставит в выводе незакрытый элемент. Строка переиспользуется, чтобы не выделять память на каждый ответ
+    std::string response_text;
+    json::Writer response_writer(response_text);
     for (const auto& request : stat_requests)
     {
-        const auto& type = request.AsMap().at("type").AsString();
-        if (type == "Stop")
+        const auto& request_map = request.AsMap();
+        const auto handler = FindRequestHandler(request_map.at("type").AsString());
+        if (!handler)
+        {
+            continue;
+        }
+        response_text.clear();
+        try
+        {
+            json::StreamBuilder builder(response_writer, responses.GetOptions(), responses.GetItemIndent());
+            (this->*handler)(request_map, builder);
+            builder.Build();
+        }
+        catch (const std::exception& error)
+        {
+            response_text.clear();
+            json::StreamBuilder builder(response_writer, responses.GetOptions(), responses.GetItemIndent());
+            WriteErrorResponse(builder, error.what(), FindRequestId(request_map));
+        }
+        responses.NextItem().Write(response_text);
+
+        // Буфер сбрасывается не только при заполнении, но и по времени,
+        // чтобы готовые ответы не ждали долгих запросов за ними
+        if (const auto now = std::chrono::steady_clock::now(); now - last_flush >= STREAM_FLUSH_INTERVAL)
         {
-            ProcessStopRequest(request.AsMap(), response_array);
+            writer->Flush();
+            last_flush = now;
         }
-        else if (type == "Bus")
+    }
+    responses.Close();
+    writer->Flush();
+    LogRouteCacheStats();
+}
+
+void InformationProcessing::ServeRequestStream(std::istream& requests)
+{
+    std::optional<json::Writer> writer;
+    OpenOutput(writer);
+    json::PrintOptions options = ReadPrintOptions(root.AsMap());
+    options.compact = true;
+    route_cache_.Clear();
+
+    std::string line;
+    std::string response_text;
+    json::Writer response_writer(response_text);
+    while (std::getline(requests, line))
+    {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
         {
-            ProcessBusRequest(request.AsMap(), response_array);
+            continue;
         }
-        else if (type == "Map")
+        // Ответ собирается отдельно: если запрос упадёт на середине, его начало не попадёт в вывод
+        response_text.clear();
+        std::optional<int> id;
+        try
         {
-            ProcessMapRequest(request.AsMap(), response_array);
+            const json::Document document = json::Load(std::string_view(line));
+            const auto& request = document.GetRoot().AsMap();
+            id = FindRequestId(request);
+            const auto handler = FindRequestHandler(request.at("type").AsString());
+            if (!handler)
+            {
+                throw std::invalid_argument("Unknown request type");
+            }
+            json::StreamBuilder builder(response_writer, options);
+            (this->*handler)(request, builder);
+            builder.Build();
         }
-        else if (type == "Route")
+        catch (const std::exception& error)
         {
-            ProcessRouteRequest(request.AsMap(), response_array);
+            // Ошибка в одном запросе не останавливает поток: вместо ответа выводится её описание
+            response_text.clear();
+            json::StreamBuilder builder(response_writer, options);
+            WriteErrorResponse(builder, error.what(), id);
         }
+        writer->Write(response_text);
+        writer->Put('\n');
+        writer->Flush();
+    }
+    LogRouteCacheStats();
+}
+
+void InformationProcessing::LogRouteCacheStats() const
+{
+    if (!router_options_.log_metrics)
+    {
+        return;
+    }
+    const RouteCacheStats& stats = route_cache_.GetStats();
+    std::cerr << "{\"event\": \"route_cache\""
+        << ", \"capacity\": " << route_cache_.GetCapacity()
+        << ", \"hits\": " << stats.hits
+        << ", \"misses\": " << stats.misses
+        << ", \"evictions\": " << stats.evictions
+        << "}" << std::endl;
+}
+
+void InformationProcessing::OpenOutput(std::optional<json::Writer>& writer)
+{
+    if (output_fd_ >= 0)
+    {
+        writer.emplace(output_fd_);
+    }
+    else
+    {
+        writer.emplace(out);
+    }
+}
+
+InformationProcessing::RequestHandler InformationProcessing::FindRequestHandler(std::string_view type)
+{
+    if (type == "Stop")
+    {
+        return &InformationProcessing::ProcessStopRequest;
+    }
+    else if (type == "Bus")
+    {
+        return &InformationProcessing::ProcessBusRequest;
+    }
+    else if (type == "Map")
+    {
+        return &InformationProcessing::ProcessMapRequest;
+    }
+    else if (type == "Route")
+    {
+        return &InformationProcessing::ProcessRouteRequest;
+    }
+    else if (type == "Isochrone")
+    {
+        return &InformationProcessing::ProcessIsochroneRequest;
+    }
+    else if (type == "Disruption")
+    {
+        return &InformationProcessing::ProcessDisruptionRequest;
+    }
+    else if (type == "Reachability")
+    {
+        return &InformationProcessing::ProcessReachabilityRequest;
     }
-    json::Document doc(json::Node(std::move(response_array)));
-    json::Print(doc, out);
+    else if (type == "Update")
+    {
+        return &InformationProcessing::ProcessUpdateRequest;
+    }
+    return nullptr;
 }
 
 void InformationProcessing::ProcessRendererSet(const json::Dict& renderer_settings)
@@ -183,16 +708,161 @@ void InformationProcessing::ProcessRoutingSettings(const json::Dict& routing_set
     bus_wait_time_ = routing_settings.at("bus_wait_time").AsInt();
     bus_velocity_ = routing_settings.at("bus_velocity").AsDouble();
     transport_router_.reset();
+
+    router_options_ = RouterOptions{};
+    if (const auto it = routing_settings.find("router_backend"); it != routing_settings.end())
+    {
+        const auto& backend = it->second.AsString();
+        if (backend == "auto")
+        {
+            router_options_.backend = RouterBackend::Auto;
+        }
+        else if (backend == "all_pairs")
+        {
+            router_options_.backend = RouterBackend::AllPairs;
+        }
+        else if (backend == "on_demand")
+        {
+            router_options_.backend = RouterBackend::OnDemand;
+        }
+        else if (backend == "partitioned")
+        {
+            router_options_.backend = RouterBackend::Partitioned;
+        }
+        else
+        {
+            throw std::logic_error("Unknown router backend: " + backend);
+        }
+    }
+    if (const auto it = routing_settings.find("router_memory_budget_mb"); it != routing_settings.end())
+    {
+        router_options_.memory_budget = static_cast<size_t>(std::max(it->second.AsDouble(), 0.0) * 1024 * 1024);
+    }
+    if (const auto it = routing_settings.find("router_cell_size"); it != routing_settings.end())
+    {
+        router_options_.cell_size = static_cast<size_t>(std::max(it->second.AsInt(), 1));
+    }
+    if (const auto it = routing_settings.find("router_max_boundary_share"); it != routing_settings.end())
+    {
+        router_options_.max_boundary_share = it->second.AsDouble();
+    }
+    // Профили задают свои время ожидания и скорость, недостающее берётся из основных настроек
+    if (const auto it = routing_settings.find("profiles"); it != routing_settings.end())
+    {
+        for (const auto& [name, profile_node] : it->second.AsMap())
+        {
+            const auto& profile_settings = profile_node.AsMap();
+            RoutingProfile profile{ name, bus_wait_time_, bus_velocity_ };
+            if (const auto wait_it = profile_settings.find("bus_wait_time"); wait_it != profile_settings.end())
+            {
+                profile.bus_wait_time = wait_it->second.AsInt();
+            }
+            if (const auto velocity_it = profile_settings.find("bus_velocity"); velocity_it != profile_settings.end())
+            {
+                profile.bus_velocity = velocity_it->second.AsDouble();
+            }
+            router_options_.profiles.push_back(std::move(profile));
+        }
+    }
+
+    if (const auto it = routing_settings.find("log_metrics"); it != routing_settings.end())
+    {
+        router_options_.log_metrics = it->second.AsBool();
+    }
+
+    route_cache_.Clear();
+    if (const auto it = routing_settings.find("route_cache_size"); it != routing_settings.end())
+    {
+        route_cache_.SetCapacity(static_cast<size_t>(std::max(it->second.AsInt(), 0)));
+    }
+
+    warmup_origins_ = CollectWarmUpOrigins(routing_settings, root.AsMap());
+    StartRouterBuild();
 }
 
-void InformationProcessing::ProcessStopRequest(const json::Dict& stop_request, json::Array& response_array)
+void InformationProcessing::StartRouterBuild(std::vector<std::string> suspended_buses, std::vector<std::string> suspended_stops)
+{
+    // Каталог к этому моменту заполнен и до готовности роутера только читается, поэтому роутер
+    // можно строить параллельно с ответами на запросы Stop/Bus/Map
+    if (transport_router_future_.valid())
+    {
+        transport_router_future_.wait();
+    }
+    // Прогрев входит в фоновую сборку: роутер считается готовым, когда тёплые остановки посчитаны
+    transport_router_future_ = std::async(std::launch::async,
+        [this, bus_wait_time = bus_wait_time_, bus_velocity = bus_velocity_, options = router_options_,
+            warmup_origins = warmup_origins_, suspended_buses = std::move(suspended_buses),
+            suspended_stops = std::move(suspended_stops)] {
+            auto router = std::make_unique<TransportRouter>(catalogue_, bus_wait_time, bus_velocity, options);
+            if (!warmup_origins.empty())
+            {
+                router->WarmUp(std::vector<std::string_view>(warmup_origins.begin(), warmup_origins.end()));
+            }
+            for (const auto& bus : suspended_buses)
+            {
+                router->SuspendBus(bus);
+            }
+            for (const auto& stop : suspended_stops)
+            {
+                router->SuspendStop(stop);
+            }
+            return router;
+        });
+}
+
+std::optional<graph::ProfileId> InformationProcessing::FindRequestProfile(const json::Dict& request) const
+{
+    const auto it = request.find("profile");
+    if (it == request.end())
+    {
+        return 0;
+    }
+    // Номера профилей у роутера совпадают с порядком в router_options_, поэтому
+    // профиль находится, не дожидаясь сборки роутера
+    const auto& profiles = router_options_.profiles;
+    const auto profile_it = std::find_if(profiles.begin(), profiles.end(), [&it](const RoutingProfile& profile)
+    {
+        return profile.name == it->second.AsString();
+    });
+    if (profile_it == profiles.end())
+    {
+        return std::nullopt;
+    }
+    return static_cast<graph::ProfileId>(profile_it - profiles.begin()) + 1;
+}
+
+RoutingProfile InformationProcessing::GetProfileSettings(graph::ProfileId profile) const
+{
+    if (profile == 0)
+    {
+        return RoutingProfile{ "", bus_wait_time_, bus_velocity_ };
+    }
+    return router_options_.profiles.at(profile - 1);
+}
+
+TransportRouter& InformationProcessing::GetRouter()
+{
+    if (!transport_router_)
+    {
+        if (transport_router_future_.valid())
+        {
+            transport_router_ = transport_router_future_.get();
+        }
+        else
+        {
+            transport_router_ = std::make_unique<TransportRouter>(catalogue_, bus_wait_time_, bus_velocity_, router_options_);
+        }
+    }
+    return *transport_router_;
+}
+
+void InformationProcessing::ProcessStopRequest(const json::Dict& stop_request, json::StreamBuilder& builder)
 {
     const std::string name = stop_request.at("name").AsString();
     int id = stop_request.at("id").AsInt();
     const std::set<std::string>* buses_ptr = catalogue_.GetBusesByStop(name);
 
-    json::Builder builder;
-    builder.StartDict().Key("request_id").Value(id);
+    builder.StartDict();
     if (catalogue_.FindStop(name) == NULL)
     {
         builder.Key("error_message").Value("not found");
@@ -212,93 +882,371 @@ void InformationProcessing::ProcessStopRequest(const json::Dict& stop_request, j
         builder.Key("buses").StartArray().EndArray();
     }
 
-    builder.EndDict();
-    response_array.push_back(builder.Build());
+    builder.Key("request_id").Value(id).EndDict();
 }
 
-void InformationProcessing::ProcessBusRequest(const json::Dict& bus_request, json::Array& response_array)
+void InformationProcessing::ProcessBusRequest(const json::Dict& bus_request, json::StreamBuilder& builder)
 {
     const std::string name = bus_request.at("name").AsString();
     int id = bus_request.at("id").AsInt();
     auto bus_info_opt = catalogue_.GetBusInfo(name);
 
-    json::Builder builder;
-    builder.StartDict()
-        .Key("request_id").Value(id);
+    builder.StartDict();
 
     if (bus_info_opt)
     {
         const auto& bus_info = *bus_info_opt;
         builder.Key("curvature").Value(bus_info.curvature)
+            .Key("request_id").Value(id)
             .Key("route_length").Value(bus_info.full_route_length)
             .Key("stop_count").Value(bus_info.total_stops)
             .Key("unique_stop_count").Value(bus_info.unique_stops);
     }
     else
     {
-        builder.Key("error_message").Value("not found");
+        builder.Key("error_message").Value("not found")
+            .Key("request_id").Value(id);
     }
 
     builder.EndDict();
-    response_array.push_back(builder.Build());
 }
 
-void InformationProcessing::ProcessMapRequest(const json::Dict& map_request, json::Array& response_array)
+void InformationProcessing::ProcessMapRequest(const json::Dict& map_request, json::StreamBuilder& builder)
 {
     int id = map_request.at("id").AsInt();
 
-    json::Builder builder;
+    if (is_map_outdated_)
+    {
+        RenderMap();
+    }
     builder.StartDict()
-        .Key("request_id").Value(id)
         .Key("map").Value(os.str())
+        .Key("request_id").Value(id)
         .EndDict();
-
-    response_array.push_back(builder.Build());
 }
 
-void InformationProcessing::ProcessRouteRequest(const json::Dict& route_request, json::Array& response_array)
+void InformationProcessing::ProcessRouteRequest(const json::Dict& route_request, json::StreamBuilder& builder)
 {
-    if (!transport_router_) {
-        transport_router_.emplace(catalogue_, bus_wait_time_, bus_velocity_);
+    int id = route_request.at("id").AsInt();
+    const auto& from = route_request.at("from").AsString();
+    const auto& to = route_request.at("to").AsString();
+
+    const auto profile = FindRequestProfile(route_request);
+    if (!profile)
+    {
+        builder.StartDict()
+            .Key("error_message").Value("not found")
+            .Key("request_id").Value(id)
+            .EndDict();
+        return;
     }
 
-    int id = route_request.at("id").AsInt();
-    const auto from = route_request.at("from").AsString();
-    const auto to = route_request.at("to").AsString();
+    // С параметром k возвращается список альтернативных маршрутов
+    if (const auto k_it = route_request.find("k"); k_it != route_request.end())
+    {
+        builder.StartDict();
 
-    json::Builder builder;
-    builder.StartDict().Key("request_id").Value(id);
+        const auto routes = GetRouter().FindRoutes(from, to, static_cast<size_t>(std::max(k_it->second.AsInt(), 0)), *profile);
+        if (routes.empty())
+        {
+            builder.Key("error_message").Value("not found")
+                .Key("request_id").Value(id);
+        }
+        else
+        {
+            builder.Key("request_id").Value(id)
+                .Key("routes").StartArray();
+            for (const auto& route : routes)
+            {
+                builder.StartDict().Key("items").StartArray();
+                for (const auto& item : route.items)
+                {
+                    WriteRouteItem(builder, item);
+                }
+                builder.EndArray()
+                    .Key("total_time").Value(route.total_time)
+                    .EndDict();
+            }
+            builder.EndArray();
+        }
+        builder.EndDict();
+        return;
+    }
 
-    auto route_info = transport_router_->FindRoute(from, to);
+    // Без кеша элементы маршрута выводятся по мере обхода, без промежуточных контейнеров.
+    // Посетитель вызывается, только если маршрут найден, поэтому "items" открывается на первом элементе
+    if (route_cache_.GetCapacity() == 0)
+    {
+        builder.StartDict();
+        bool has_items = false;
+        const auto total_time = GetRouter().ForEachRouteItem(from, to, [&builder, &has_items](const RouteItem& item)
+        {
+            if (!has_items)
+            {
+                builder.Key("items").StartArray();
+                has_items = true;
+            }
+            WriteRouteItem(builder, item);
+        }, *profile);
+        if (!total_time)
+        {
+            builder.Key("error_message").Value("not found")
+                .Key("request_id").Value(id);
+        }
+        else
+        {
+            if (!has_items)
+            {
+                builder.Key("items").StartArray();
+            }
+            builder.EndArray()
+                .Key("request_id").Value(id)
+                .Key("total_time").Value(*total_time);
+        }
+        builder.EndDict();
+        return;
+    }
 
-    if (!route_info) {
-        builder.Key("error_message").Value("not found");
+    // Повторные запросы той же пары остановок собираются из текста, выведенного при первом запросе
+    const RoutingProfile profile_settings = GetProfileSettings(*profile);
+    const RouteCacheKey cache_key{ catalogue_.FindStop(from), catalogue_.FindStop(to),
+        profile_settings.bus_wait_time, profile_settings.bus_velocity };
+    builder.StartDict();
+    if (const CachedRoute* cached_route = route_cache_.Find(cache_key, catalogue_.GetVersion()))
+    {
+        WriteCachedRoute(builder, *cached_route, id);
+        builder.EndDict();
+        return;
+    }
+
+    // Текст выводится с отступом значений словаря ответа — там, куда его вставит WriteCachedRoute
+    CachedRoute route;
+    std::optional<double> total_time;
+    {
+        json::Writer items_writer(route.items);
+        json::StreamBuilder items_builder(items_writer, builder.GetOptions(), builder.GetValueIndent());
+        items_builder.StartArray();
+        total_time = GetRouter().ForEachRouteItem(from, to, [&items_builder](const RouteItem& item)
+        {
+            WriteRouteItem(items_builder, item);
+        }, *profile);
+        items_builder.EndArray();
+    }
+    if (!total_time)
+    {
+        route.items.clear();
+    }
+    else
+    {
+        json::Writer time_writer(route.total_time);
+        time_writer.WriteDouble(*total_time, builder.GetOptions());
+    }
+    WriteCachedRoute(builder, route, id);
+    builder.EndDict();
+    route_cache_.Insert(cache_key, std::move(route));
+}
+
+void InformationProcessing::ProcessIsochroneRequest(const json::Dict& isochrone_request, json::StreamBuilder& builder)
+{
+    int id = isochrone_request.at("id").AsInt();
+    const auto& from = isochrone_request.at("from").AsString();
+    double max_time = isochrone_request.at("max_time").AsDouble();
+    const auto profile = FindRequestProfile(isochrone_request);
+
+    builder.StartDict();
+
+    const auto stops = profile ? GetRouter().FindReachableStops(from, max_time, *profile) : std::nullopt;
+    if (!stops)
+    {
+        builder.Key("error_message").Value("not found")
+            .Key("request_id").Value(id);
     }
     else
     {
-        builder.Key("total_time").Value(route_info->total_time);
-        builder.Key("items").StartArray();
-        for (const auto& item : route_info->items)
+        builder.Key("request_id").Value(id)
+            .Key("stops").StartArray();
+        for (const auto& stop : *stops)
         {
             builder.StartDict()
-                .Key("type").Value(item.type == RouteItem::ItemType::Wait ? "Wait" : "Bus");
-            if (item.type == RouteItem::ItemType::Wait)
+                .Key("stop_name").Value(stop.name)
+                .Key("time").Value(stop.time)
+                .EndDict();
+        }
+        builder.EndArray();
+    }
+
+    builder.EndDict();
+}
+
+void InformationProcessing::ProcessDisruptionRequest(const json::Dict& disruption_request, json::StreamBuilder& builder)
+{
+    int id = disruption_request.at("id").AsInt();
+    TransportRouter& router = GetRouter();
+
+    auto for_each_name = [&disruption_request](const std::string& key, auto&& action)
+    {
+        if (const auto it = disruption_request.find(key); it != disruption_request.end())
+        {
+            for (const auto& name : it->second.AsArray())
             {
-                builder.Key("stop_name").Value(item.name);
+                action(name.AsString());
             }
-            else
-            { 
-                builder.Key("bus").Value(item.name)
-                    .Key("span_count").Value(static_cast<int>(item.span_count));
-            }
-            builder.Key("time").Value(item.time);
-            builder.EndDict();
+        }
+    };
+
+    // Запрос с неизвестным названием не применяется вовсе: иначе ответ "not found"
+    // скрывал бы, что часть перерывов всё же вступила в силу
+    bool is_found = true;
+    auto check_bus = [&router, &is_found](const std::string& name) { is_found = is_found && router.HasBus(name); };
+    auto check_stop = [&router, &is_found](const std::string& name) { is_found = is_found && router.HasStop(name); };
+    for_each_name("suspend_buses", check_bus);
+    for_each_name("resume_buses", check_bus);
+    for_each_name("suspend_stops", check_stop);
+    for_each_name("resume_stops", check_stop);
+    if (!is_found)
+    {
+        builder.StartDict()
+            .Key("error_message").Value("not found")
+            .Key("request_id").Value(id)
+            .EndDict();
+        return;
+    }
+
+    if (const auto it = disruption_request.find("resume_all"); it != disruption_request.end() && it->second.AsBool())
+    {
+        router.ResumeAll();
+    }
+    for_each_name("suspend_buses", [&router](const std::string& name) { router.SuspendBus(name); });
+    for_each_name("resume_buses", [&router](const std::string& name) { router.ResumeBus(name); });
+    for_each_name("suspend_stops", [&router](const std::string& name) { router.SuspendStop(name); });
+    for_each_name("resume_stops", [&router](const std::string& name) { router.ResumeStop(name); });
+
+    // Готовые ответы на Route могли пройти через приостановленный автобус
+    route_cache_.Clear();
+
+    builder.StartDict()
+        .Key("request_id").Value(id)
+        .Key("suspended_buses").StartArray();
+    for (const auto bus : router.GetSuspendedBuses())
+    {
+        builder.Value(bus);
+    }
+    builder.EndArray().Key("suspended_stops").StartArray();
+    for (const auto stop : router.GetSuspendedStops())
+    {
+        builder.Value(stop);
+    }
+    builder.EndArray()
+        .EndDict();
+}
+
+void InformationProcessing::ProcessReachabilityRequest(const json::Dict& reachability_request, json::StreamBuilder& builder)
+{
+    int id = reachability_request.at("id").AsInt();
+    auto stops = GetRouter().GetReachability();
+
+    // С полем "stop" отвечает только про одну остановку
+    if (const auto it = reachability_request.find("stop"); it != reachability_request.end())
+    {
+        const std::string& name = it->second.AsString();
+        stops.erase(std::remove_if(stops.begin(), stops.end(),
+            [&name](const StopReachability& stop) { return stop.name != name; }), stops.end());
+    }
+
+    builder.StartDict();
+    if (stops.empty())
+    {
+        builder.Key("error_message").Value("not found")
+            .Key("request_id").Value(id);
+    }
+    else
+    {
+        builder.Key("request_id").Value(id)
+            .Key("stops").StartArray();
+        for (const auto& stop : stops)
+        {
+            builder.StartDict()
+                .Key("reachable_stop_count").Value(static_cast<int>(stop.reachable_stop_count))
+                .Key("reaching_stop_count").Value(static_cast<int>(stop.reaching_stop_count))
+                .Key("stop_name").Value(stop.name)
+                .EndDict();
         }
         builder.EndArray();
     }
 
     builder.EndDict();
-    response_array.push_back(builder.Build());
 }
 
+void InformationProcessing::ProcessUpdateRequest(const json::Dict& update_request, json::StreamBuilder& builder)
+{
+    int id = update_request.at("id").AsInt();
+    const auto& base_requests = update_request.at("base_requests").AsArray();
+
+    // Каталог можно менять, только когда фоновая сборка роутера перестала его читать
+    TransportRouter& router = GetRouter();
+
+    // Порядок тот же, что при разборе документа: остановки, расстояния, автобусы
+    bool has_new_stops = false;
+    for (const auto& request : base_requests)
+    {
+        const auto& request_map = request.AsMap();
+        if (request_map.at("type").AsString() == "Stop" && !catalogue_.FindStop(request_map.at("name").AsString()))
+        {
+            ProcessStop(request_map);
+            has_new_stops = true;
+        }
+    }
+
+    std::vector<std::pair<std::string_view, std::string_view>> distances;
+    for (const auto& request : base_requests)
+    {
+        const auto& request_map = request.AsMap();
+        const auto distances_it = request_map.find("road_distances");
+        if (request_map.at("type").AsString() != "Stop" || distances_it == request_map.end())
+        {
+            continue;
+        }
+        ProcessStopWithDistance(request_map);
+        for (const auto& [stop_name, distance_node] : distances_it->second.AsMap())
+        {
+            distances.emplace_back(request_map.at("name").AsString(), stop_name);
+        }
+    }
+
+    std::vector<std::string_view> buses;
+    for (const auto& request : base_requests)
+    {
+        const auto& request_map = request.AsMap();
+        if (request_map.at("type").AsString() != "Bus")
+        {
+            continue;
+        }
+        const auto& name = request_map.at("name").AsString();
+        catalogue_.RemoveBus(name);
+        if (const auto it = request_map.find("remove"); it == request_map.end() || !it->second.AsBool())
+        {
+            ProcessBus(request_map);
+        }
+        buses.push_back(name);
+    }
+
+    if (has_new_stops)
+    {
+        // Перерывы в движении переносятся на новый роутер
+        const auto suspended_bus_views = router.GetSuspendedBuses();
+        const auto suspended_stop_views = router.GetSuspendedStops();
+        std::vector<std::string> suspended_buses(suspended_bus_views.begin(), suspended_bus_views.end());
+        std::vector<std::string> suspended_stops(suspended_stop_views.begin(), suspended_stop_views.end());
+        transport_router_.reset();
+        StartRouterBuild(std::move(suspended_buses), std::move(suspended_stops));
+    }
+    else
+    {
+        router.Update(buses, distances);
+    }
+    is_map_outdated_ = true;
 
+    builder.StartDict()
+        .Key("request_id").Value(id)
+        .EndDict();
+}
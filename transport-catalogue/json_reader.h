@@ -1,11 +1,17 @@
 #pragma once
+#include <future>
+#include <memory>
+#include <optional>
 #include <vector>
 #include <string>
 #include <sstream>
 
 #include "transport_catalogue.h"
 #include "json.h"
+#include "json_arena.h"
+#include "json_builder.h"
 #include "map_renderer.h"
+#include "route_cache.h"
 #include "transport_router.h"
 
 class InformationProcessing
@@ -13,22 +19,19 @@ class InformationProcessing
 public:
 
     InformationProcessing(TransportCatalogue& catalogue, std::istream& input_stream_, std::ostream& out_);
+    // Документ, уже целиком лежащий в памяти, разбирается в арену: строки элементов
+    // base_requests не копируются, а указывают в текст
+    InformationProcessing(TransportCatalogue& catalogue, std::string document_text, std::ostream& out_);
 
     void Process()
     {
-        const auto& base_requests = root.AsMap().at("base_requests").AsArray();
-        ProcessBaseRequests(base_requests);
-
         const auto& render_settings = root.AsMap().at("render_settings").AsMap();
         ProcessRendererSet(render_settings);
 
         const auto& routing_settings = root.AsMap().at("routing_settings").AsMap();
         ProcessRoutingSettings(routing_settings);
 
-        svg::Document svg_doc;
-        MapRenderer mr(set);
-        mr.RenderStopsAndBuses(catalogue_, svg_doc);
-        svg_doc.Render(os);
+        RenderMap();
     }
 
     void ProcessRequest()
@@ -38,36 +41,100 @@ public:
             ProcessStatRequests(stat_requests);
     }
 
+    // base_requests входного документа уже внесены в каталог при разборе в конструкторе;
+    // метод нужен для запросов, собранных отдельно
     void ProcessBaseRequests(const json::Array& base_requests);
     void ProcessStatRequests(const json::Array& stat_requests);
+    // Долгоживущий режим: по запросу на строку из requests (NDJSON), по ответу в строку.
+    // Каталог, роутер и карта строятся один раз и переиспользуются; вывод сбрасывается после каждого ответа
+    void ServeRequestStream(std::istream& requests);
     void ProcessRendererSet(const json::Dict& renderer_settings);
     void ProcessRoutingSettings(const json::Dict& routing_settings);
 
+    const RouteCacheStats& GetRouteCacheStats() const { return route_cache_.GetStats(); }
+
+    // Ответы на stat_requests пишутся в дескриптор вызовами write(2), минуя out
+    void SetOutputDescriptor(int fd) { output_fd_ = fd; }
+
 private:
+    // Разбирает вход событиями: элементы base_requests уходят в каталог по одному,
+    // документ строится только для остальных разделов
+    class InputHandler;
+
+    // Автобус и расстояние, ссылающиеся на остановки, которых ещё не было во входе
+    struct PendingBus
+    {
+        std::string name;
+        std::vector<std::string> stops;
+        bool is_roundtrip;
+    };
+    struct PendingDistance
+    {
+        Stop* from;
+        std::string to;
+        int distance;
+    };
+
     TransportCatalogue catalogue_;
     Settings set;
-    std::optional<TransportRouter> transport_router_;
+    std::unique_ptr<TransportRouter> transport_router_;
+    std::future<std::unique_ptr<TransportRouter>> transport_router_future_;
+    RouteCache route_cache_;
 
     int bus_wait_time_ = 0;
     double bus_velocity_ = 0.0;
+    RouterOptions router_options_;
 
-    std::istream& input_stream;
     std::ostream& out;
+    int output_fd_ = -1;
     std::ostringstream os;
 
-    json::Document doc;
     json::Node root;
+    std::vector<PendingBus> pending_buses_;
+    std::vector<PendingDistance> pending_distances_;
+    std::vector<std::string> warmup_origins_;
+    // Карта перерисовывается при следующем запросе Map после изменения каталога
+    bool is_map_outdated_ = false;
+
+    using RequestHandler = void (InformationProcessing::*)(const json::Dict&, json::StreamBuilder&);
 
     svg::Color ProcessColor(const json::Node& color_node);
+    void RenderMap();
+    // Запускает фоновую сборку роутера по текущему каталогу; перерывы в движении
+    // из списков применяются к новому роутеру
+    void StartRouterBuild(std::vector<std::string> suspended_buses = {}, std::vector<std::string> suspended_stops = {});
+    // Дожидается фоновой сборки роутера (или строит его сам, если сборка не запускалась)
+    TransportRouter& GetRouter();
+    // Профиль весов из поля "profile" запроса: 0 без поля, nullopt для неизвестного профиля
+    std::optional<graph::ProfileId> FindRequestProfile(const json::Dict& request) const;
+    RoutingProfile GetProfileSettings(graph::ProfileId profile) const;
 
     void ProcessStop(const json::Dict& stop_data);
     void ProcessStopWithDistance(const json::Dict& stop_data);
     void ProcessBus(const json::Dict& bus_data);
-
-    void ProcessStopRequest(const json::Dict& stop_request, json::Array& response_array);
-    void ProcessBusRequest(const json::Dict& bus_request, json::Array& response_array);
-    void ProcessMapRequest(const json::Dict& map_request, json::Array& response_array);
-    void ProcessRouteRequest(const json::Dict& route_request, json::Array& response_array);
+    void AddBus(const std::string& name, std::vector<std::string_view> stops, bool is_roundtrip);
+    // Элемент base_requests по мере разбора: остановка вносится сразу, автобусы и расстояния
+    // до ещё не встреченных остановок откладываются до FinishBaseRequests
+    void ProcessBaseRequest(const json::ArenaDict& request);
+    void FinishBaseRequests();
+
+    // Ответы пишутся в дескриптор, если он задан, иначе в out
+    void OpenOutput(std::optional<json::Writer>& writer);
+    // Счётчики кеша маршрутов в std::cerr по окончании запросов, если включён routing_settings.log_metrics
+    void LogRouteCacheStats() const;
+    // Обработчик запроса stat_requests по его типу; nullptr для неизвестного типа
+    static RequestHandler FindRequestHandler(std::string_view type);
+    void ProcessStopRequest(const json::Dict& stop_request, json::StreamBuilder& builder);
+    void ProcessBusRequest(const json::Dict& bus_request, json::StreamBuilder& builder);
+    void ProcessMapRequest(const json::Dict& map_request, json::StreamBuilder& builder);
+    void ProcessRouteRequest(const json::Dict& route_request, json::StreamBuilder& builder);
+    void ProcessIsochroneRequest(const json::Dict& isochrone_request, json::StreamBuilder& builder);
+    void ProcessDisruptionRequest(const json::Dict& disruption_request, json::StreamBuilder& builder);
+    void ProcessReachabilityRequest(const json::Dict& reachability_request, json::StreamBuilder& builder);
+    // Изменение каталога на ходу: base_requests в том же формате, что во входном документе,
+    // автобус с "remove": true удаляется. Роутер обновляется инкрементально,
+    // а если появились новые остановки — строится заново
+    void ProcessUpdateRequest(const json::Dict& update_request, json::StreamBuilder& builder);
 };
 
 
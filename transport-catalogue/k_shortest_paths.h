@@ -0,0 +1,305 @@
+#pragma once
+
+#include "dijkstra.h"
+#include "graph.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+	// До k простых (без повторяющихся вершин) путей между парой вершин
+	// в порядке возрастания веса — алгоритм Йена.
+	// Ответвления от длинного пути ищутся параллельно потоками, которые создаются при первой
+	// надобности и живут вместе с объектом; у каждого потока своё состояние поиска,
+	// которое переиспользуется между ответвлениями и запросами. Короткие пути обходятся
+	// в вызывающем потоке: там запуск потоков дороже самих поисков.
+	// Рёбра, признанные эквивалентными, не дают разных путей: иначе параллельные рёбра
+	// с одинаковым смыслом порождают неотличимые друг от друга альтернативы
+	template <typename Weight>
+	class KShortestPaths {
+	private:
+		using Graph = DirectedWeightedGraph<Weight>;
+
+	public:
+		struct Path {
+			Weight weight;
+			std::vector<EdgeId> edges;
+		};
+
+		using EdgeEquivalence = std::function<bool(EdgeId, EdgeId)>;
+		using EdgeFilter = std::function<bool(EdgeId)>;
+
+		explicit KShortestPaths(const Graph& graph, EdgeEquivalence are_equivalent = std::equal_to<EdgeId>{},
+			size_t worker_count = std::thread::hardware_concurrency(), ProfileId profile = 0);
+		KShortestPaths(const KShortestPaths&) = delete;
+		KShortestPaths& operator=(const KShortestPaths&) = delete;
+		~KShortestPaths();
+
+		// Если задан is_edge_allowed, пути обходят рёбра, для которых он возвращает false
+		std::vector<Path> Find(VertexId from, VertexId to, size_t k, const EdgeFilter& is_edge_allowed = {});
+
+	private:
+		struct Worker {
+			Worker(const Graph& graph, ProfileId profile)
+				: dijkstra(graph, profile)
+				, blocked_vertices(graph.GetVertexCount())
+			{
+			}
+
+			Dijkstra<Weight> dijkstra;
+			// Номер ответвления, в котором вершина или ребро запрещены: так запреты
+			// не приходится сбрасывать перед каждым поиском
+			std::vector<size_t> blocked_vertices;
+			std::vector<size_t> blocked_edges;
+			size_t spur_id = 0;
+		};
+
+		// Ответвлений меньше — поиск идёт без потоков
+		static constexpr size_t MIN_PARALLEL_SPUR_COUNT = 8;
+
+		std::optional<Path> FindSpurPath(Worker& worker, const std::vector<Path>& found_paths,
+			const std::vector<Weight>& root_weights, VertexId from, VertexId to, size_t spur_index,
+			const EdgeFilter& is_edge_allowed) const;
+		bool AreEquivalent(const std::vector<EdgeId>& lhs, const std::vector<EdgeId>& rhs) const {
+			return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), are_equivalent_);
+		}
+		// Выполняет task(worker_index) для всех рабочих состояний: нулевое — в вызывающем потоке
+		void RunOnWorkers(const std::function<void(size_t)>& task);
+		void ServeWorker(size_t worker_index);
+
+		const Graph& graph_;
+		ProfileId profile_;
+		EdgeEquivalence are_equivalent_;
+		std::vector<Worker> workers_;
+
+		// Потоки для workers_[1..]: ждут новое поколение задачи и отчитываются, уменьшая pending_
+		std::vector<std::thread> threads_;
+		std::mutex mutex_;
+		std::condition_variable task_ready_;
+		std::condition_variable task_done_;
+		const std::function<void(size_t)>* task_ = nullptr;
+		size_t generation_ = 0;
+		size_t pending_ = 0;
+		bool is_stopping_ = false;
+		std::exception_ptr error_;
+	};
+
+	template <typename Weight>
+	KShortestPaths<Weight>::KShortestPaths(const Graph& graph, EdgeEquivalence are_equivalent, size_t worker_count,
+		ProfileId profile)
+		: graph_(graph)
+		, profile_(profile)
+		, are_equivalent_(std::move(are_equivalent))
+	{
+		workers_.reserve(std::max<size_t>(worker_count, 1));
+		for (size_t i = 0; i < std::max<size_t>(worker_count, 1); ++i) {
+			workers_.emplace_back(graph, profile);
+		}
+	}
+
+	template <typename Weight>
+	KShortestPaths<Weight>::~KShortestPaths() {
+		{
+			std::lock_guard lock(mutex_);
+			is_stopping_ = true;
+		}
+		task_ready_.notify_all();
+		for (auto& thread : threads_) {
+			thread.join();
+		}
+	}
+
+	template <typename Weight>
+	void KShortestPaths<Weight>::ServeWorker(size_t worker_index) {
+		size_t served_generation = 0;
+		while (true) {
+			const std::function<void(size_t)>* task = nullptr;
+			{
+				std::unique_lock lock(mutex_);
+				task_ready_.wait(lock, [this, served_generation] { return is_stopping_ || generation_ != served_generation; });
+				if (is_stopping_) {
+					return;
+				}
+				served_generation = generation_;
+				task = task_;
+			}
+
+			std::exception_ptr error;
+			try {
+				(*task)(worker_index);
+			}
+			catch (...) {
+				error = std::current_exception();
+			}
+
+			std::lock_guard lock(mutex_);
+			if (error && !error_) {
+				error_ = error;
+			}
+			if (--pending_ == 0) {
+				task_done_.notify_one();
+			}
+		}
+	}
+
+	template <typename Weight>
+	void KShortestPaths<Weight>::RunOnWorkers(const std::function<void(size_t)>& task) {
+		if (threads_.empty()) {
+			for (size_t worker_index = 1; worker_index < workers_.size(); ++worker_index) {
+				threads_.emplace_back([this, worker_index] { ServeWorker(worker_index); });
+			}
+		}
+		{
+			std::lock_guard lock(mutex_);
+			task_ = &task;
+			pending_ = threads_.size();
+			error_ = nullptr;
+			++generation_;
+		}
+		task_ready_.notify_all();
+
+		std::exception_ptr error;
+		try {
+			task(0);
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+
+		std::unique_lock lock(mutex_);
+		task_done_.wait(lock, [this] { return pending_ == 0; });
+		if (!error) {
+			error = error_;
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	template <typename Weight>
+	std::vector<typename KShortestPaths<Weight>::Path> KShortestPaths<Weight>::Find(VertexId from, VertexId to, size_t k,
+		const EdgeFilter& is_edge_allowed) {
+		std::vector<Path> found_paths;
+		if (k == 0) {
+			return found_paths;
+		}
+		for (Worker& worker : workers_) {
+			worker.blocked_edges.resize(graph_.GetEdgeCount());
+		}
+
+		auto& first_search = workers_.front().dijkstra;
+		first_search.Run(from, to, [&is_edge_allowed](EdgeId edge_id) {
+			return !is_edge_allowed || is_edge_allowed(edge_id);
+			});
+		if (!first_search.IsReached(to)) {
+			return found_paths;
+		}
+		found_paths.push_back(Path{ first_search.GetWeight(to), first_search.GetPathEdges(to) });
+
+		std::set<std::pair<Weight, std::vector<EdgeId>>> candidates;
+		while (found_paths.size() < k) {
+			const Path& last_path = found_paths.back();
+			const size_t spur_count = last_path.edges.size();
+
+			// Веса корневых частей общие для всех ответвлений
+			std::vector<Weight> root_weights(spur_count + 1, Weight{});
+			for (size_t i = 0; i < spur_count; ++i) {
+				root_weights[i + 1] = AddWeights(root_weights[i], graph_.GetEdgeWeight(last_path.edges[i], profile_));
+			}
+
+			std::vector<std::optional<Path>> spur_paths(spur_count);
+			const size_t worker_count = spur_count < MIN_PARALLEL_SPUR_COUNT ? 1 : workers_.size();
+			const std::function<void(size_t)> find_spur_paths = [&](size_t worker_index) {
+				for (size_t i = worker_index; i < spur_count; i += worker_count) {
+					spur_paths[i] = FindSpurPath(workers_[worker_index], found_paths, root_weights, from, to, i, is_edge_allowed);
+				}
+			};
+			if (worker_count == 1) {
+				find_spur_paths(0);
+			}
+			else {
+				RunOnWorkers(find_spur_paths);
+			}
+
+			// Кандидат, эквивалентный найденному пути, отбрасывается, а из эквивалентных
+			// кандидатов остаётся самый лёгкий — так же, как эквивалентные рёбра блокируются
+			for (auto& spur_path : spur_paths) {
+				if (!spur_path || std::any_of(found_paths.begin(), found_paths.end(), [this, &spur_path](const Path& path) {
+						return AreEquivalent(path.edges, spur_path->edges);
+					})) {
+					continue;
+				}
+				const auto equivalent_it = std::find_if(candidates.begin(), candidates.end(), [this, &spur_path](const auto& candidate) {
+					return AreEquivalent(candidate.second, spur_path->edges);
+					});
+				if (equivalent_it != candidates.end()) {
+					if (!(spur_path->weight < equivalent_it->first)) {
+						continue;
+					}
+					candidates.erase(equivalent_it);
+				}
+				candidates.emplace(spur_path->weight, std::move(spur_path->edges));
+			}
+			if (candidates.empty()) {
+				break;
+			}
+			auto best = candidates.extract(candidates.begin());
+			found_paths.push_back(Path{ best.value().first, std::move(best.value().second) });
+		}
+
+		return found_paths;
+	}
+
+	template <typename Weight>
+	std::optional<typename KShortestPaths<Weight>::Path> KShortestPaths<Weight>::FindSpurPath(Worker& worker,
+		const std::vector<Path>& found_paths, const std::vector<Weight>& root_weights,
+		VertexId from, VertexId to, size_t spur_index, const EdgeFilter& is_edge_allowed) const {
+		const auto& root_edges = found_paths.back().edges;
+		const size_t spur_id = ++worker.spur_id;
+		const VertexId spur_vertex = spur_index == 0 ? from : graph_.GetEdge(root_edges[spur_index - 1]).to;
+
+		// Путь не должен возвращаться в вершины корня и повторять уже найденные продолжения
+		for (size_t i = 0; i < spur_index; ++i) {
+			worker.blocked_vertices[graph_.GetEdge(root_edges[i]).from] = spur_id;
+		}
+		for (const Path& path : found_paths) {
+			if (path.edges.size() > spur_index
+				&& std::equal(path.edges.begin(), path.edges.begin() + spur_index, root_edges.begin(), are_equivalent_)) {
+				const EdgeId next_edge_id = path.edges[spur_index];
+				for (const EdgeId edge_id : graph_.GetIncidentEdges(graph_.GetEdge(next_edge_id).from)) {
+					if (are_equivalent_(edge_id, next_edge_id)) {
+						worker.blocked_edges[edge_id] = spur_id;
+					}
+				}
+			}
+		}
+
+		worker.dijkstra.Run(spur_vertex, to, [this, &worker, spur_id, &is_edge_allowed](EdgeId edge_id) {
+			return worker.blocked_edges[edge_id] != spur_id
+				&& worker.blocked_vertices[graph_.GetEdge(edge_id).to] != spur_id
+				&& (!is_edge_allowed || is_edge_allowed(edge_id));
+			});
+		if (!worker.dijkstra.IsReached(to)) {
+			return std::nullopt;
+		}
+
+		const Weight weight = AddWeights(root_weights[spur_index], worker.dijkstra.GetWeight(to));
+		if (!(weight < UnreachableWeight<Weight>())) {
+			return std::nullopt;
+		}
+		Path path{ weight, std::vector<EdgeId>(root_edges.begin(), root_edges.begin() + spur_index) };
+		const auto spur_edges = worker.dijkstra.GetPathEdges(to);
+		path.edges.insert(path.edges.end(), spur_edges.begin(), spur_edges.end());
+		return path;
+	}
+
+} // namespace graph
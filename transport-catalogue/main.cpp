@@ -1,16 +1,49 @@
-#include <iostream>
+#include <cstdio>
 #include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
 #include "json_reader.h"
 #include "transport_catalogue.h"
 
-int main()
+// Без аргументов: один документ из std::cin и ответы на его stat_requests.
+// --ndjson [base.json]: base_requests и настройки из файла (или из первой строки std::cin),
+// затем запросы по одному на строку из std::cin и ответ на каждый отдельной строкой
+int main(int argc, char* argv[])
 {
     TransportCatalogue catalogue;
-    //std::ifstream input_file("Текст.txt");
-    //std::ifstream input_file("Пример1.txt");
+
+    if (argc >= 2 && std::string_view(argv[1]) == "--ndjson")
+    {
+        std::ifstream base_file;
+        std::optional<InformationProcessing> processor;
+        if (argc >= 3)
+        {
+            base_file.open(argv[2]);
+            if (!base_file)
+            {
+                std::cerr << "Cannot open " << argv[2] << std::endl;
+                return 1;
+            }
+            processor.emplace(catalogue, base_file, std::cout);
+        }
+        else
+        {
+            // Первая строка уже прочитана целиком, поэтому разбирается в арену без копирования строк
+            std::string line;
+            std::getline(std::cin, line);
+            processor.emplace(catalogue, std::move(line), std::cout);
+        }
+
+        processor->SetOutputDescriptor(fileno(stdout));
+        processor->Process();
+        processor->ServeRequestStream(std::cin);
+        return 0;
+    }
 
     InformationProcessing processor(catalogue, std::cin, std::cout);
-    InformationProcessing processor(catalogue, input_file, std::cout);
+    processor.SetOutputDescriptor(fileno(stdout));
     processor.Process();
     processor.ProcessRequest();
     return 0;
@@ -0,0 +1,383 @@
+#pragma once
+
+#include "dijkstra.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+	// Маршрутизация по графу, разбитому на ячейки.
+	// Граничные вершины ячейки — концы рёбер, ведущих в другие ячейки. Для каждой граничной
+	// вершины заранее строится дерево кратчайших путей внутри её ячейки, так что память
+	// растёт как сумма (граничные вершины x размер ячейки), а не V^2.
+	// Запрос: локальный поиск от начала внутри его ячейки, затем поиск по оверлею из граничных
+	// вершин (пути внутри ячеек берутся из таблиц, между ячейками — рёбра графа),
+	// затем спуск по таблицам к концу маршрута.
+	// Ячейки считаются параллельно и пересчитываются независимо друг от друга.
+	// Запросы переиспользуют общее состояние поиска и не должны выполняться параллельно
+	template <typename Weight>
+	class PartitionedRouter {
+	private:
+		using Graph = DirectedWeightedGraph<Weight>;
+
+	public:
+		using CellId = size_t;
+
+		// cell_of_vertex[v] — ячейка вершины v, ячейки нумеруются с нуля подряд
+		PartitionedRouter(const Graph& graph, std::vector<CellId> cell_of_vertex,
+			size_t worker_count = std::thread::hardware_concurrency());
+
+		template <typename EdgeVisitor>
+		std::optional<Weight> ForEachRouteEdge(VertexId from, VertexId to, EdgeVisitor&& visitor) const;
+
+		// Заново строит границу и таблицы ячейки после изменения рёбер графа.
+		// Ребро между ячейками меняет границы обеих, поэтому пересчитывать нужно ячейки обоих концов
+		void RebuildCell(CellId cell);
+
+		// Сколько вершин окажутся граничными при таком разбиении — до построения таблиц.
+		// Когда граничные почти все, таблицы строятся почти от каждой вершины, а оверлей
+		// не меньше самого графа, и разбиение только мешает
+		static size_t CountBoundaryVertices(const Graph& graph, const std::vector<CellId>& cell_of_vertex);
+
+		CellId GetCellOf(VertexId vertex) const { return cell_of_vertex_.at(vertex); }
+		size_t GetCellCount() const { return cells_.size(); }
+		size_t GetBoundaryVertexCount() const;
+		size_t GetMemoryUsage() const;
+
+	private:
+		using PrevEdgeId = std::uint32_t;
+		static constexpr PrevEdgeId NO_EDGE = std::numeric_limits<PrevEdgeId>::max();
+
+		// Дерево кратчайших путей от граничной вершины внутри ячейки,
+		// индексы — локальные номера вершин ячейки
+		struct BoundaryTree {
+			std::vector<Weight> weights;
+			std::vector<PrevEdgeId> prev_edges;
+		};
+
+		struct Cell {
+			std::vector<VertexId> vertices;
+			std::vector<VertexId> boundary_vertices;
+			std::vector<BoundaryTree> trees;
+		};
+
+		// Как вершина оверлея получила свой вес
+		enum class OverlayStep {
+			Source,
+			Cell,
+			Edge
+		};
+
+		struct OverlayState {
+			Weight weight{};
+			OverlayStep step = OverlayStep::Source;
+			// Для Cell — граничная вершина той же ячейки, для Edge — ребро между ячейками
+			size_t prev = 0;
+			size_t run = 0;
+		};
+		using QueueItem = std::pair<Weight, VertexId>;
+
+		static constexpr size_t NO_BOUNDARY = std::numeric_limits<size_t>::max();
+
+		bool IsInCell(EdgeId edge_id, CellId cell) const {
+			return cell_of_vertex_[graph_.GetEdge(edge_id).to] == cell;
+		}
+
+		std::vector<VertexId> FindBoundaryVertices(CellId cell) const;
+		void BuildTrees(CellId cell, Dijkstra<Weight>& dijkstra);
+		const BoundaryTree& GetTree(VertexId boundary_vertex) const {
+			const Cell& cell = cells_[cell_of_vertex_[boundary_vertex]];
+			return cell.trees[boundary_index_[boundary_vertex]];
+		}
+		// Рёбра пути внутри ячейки от корня дерева до vertex, в обратном порядке
+		void AppendTreePathReversed(const BoundaryTree& tree, VertexId vertex, std::vector<EdgeId>& edges) const;
+		void PushOverlay(VertexId vertex, Weight weight, OverlayStep step, size_t prev) const;
+
+		const Graph& graph_;
+		std::vector<CellId> cell_of_vertex_;
+		// Номер вершины среди вершин её ячейки и среди граничных вершин её ячейки
+		std::vector<size_t> local_index_;
+		std::vector<size_t> boundary_index_;
+		std::vector<Cell> cells_;
+
+		mutable Dijkstra<Weight> local_search_;
+		mutable std::vector<OverlayState> overlay_states_;
+		mutable std::vector<QueueItem> overlay_queue_;
+		mutable size_t overlay_run_ = 0;
+		mutable std::vector<EdgeId> route_edges_;
+	};
+
+	template <typename Weight>
+	PartitionedRouter<Weight>::PartitionedRouter(const Graph& graph, std::vector<CellId> cell_of_vertex, size_t worker_count)
+		: graph_(graph)
+		, cell_of_vertex_(std::move(cell_of_vertex))
+		, local_index_(graph.GetVertexCount())
+		, boundary_index_(graph.GetVertexCount(), NO_BOUNDARY)
+		, local_search_(graph)
+		, overlay_states_(graph.GetVertexCount())
+	{
+		if (cell_of_vertex_.size() != graph.GetVertexCount()) {
+			throw std::invalid_argument("Every vertex should be assigned to a cell");
+		}
+		const CellId cell_count = cell_of_vertex_.empty() ? 0
+			: *std::max_element(cell_of_vertex_.begin(), cell_of_vertex_.end()) + 1;
+		cells_.resize(cell_count);
+		for (VertexId vertex = 0; vertex < cell_of_vertex_.size(); ++vertex) {
+			auto& vertices = cells_[cell_of_vertex_[vertex]].vertices;
+			local_index_[vertex] = vertices.size();
+			vertices.push_back(vertex);
+		}
+
+		// Границы находятся до параллельного расчёта таблиц: потоки пишут только в таблицы своих ячеек
+		for (CellId cell = 0; cell < cell_count; ++cell) {
+			cells_[cell].boundary_vertices = FindBoundaryVertices(cell);
+			for (size_t i = 0; i < cells_[cell].boundary_vertices.size(); ++i) {
+				boundary_index_[cells_[cell].boundary_vertices[i]] = i;
+			}
+		}
+
+		worker_count = std::clamp<size_t>(worker_count, 1, std::max<size_t>(cell_count, 1));
+		auto build_cells = [this, cell_count, worker_count](size_t worker_index) {
+			Dijkstra<Weight> dijkstra(graph_);
+			for (CellId cell = worker_index; cell < cell_count; cell += worker_count) {
+				BuildTrees(cell, dijkstra);
+			}
+		};
+		std::vector<std::future<void>> tasks;
+		for (size_t worker_index = 1; worker_index < worker_count; ++worker_index) {
+			tasks.push_back(std::async(std::launch::async, build_cells, worker_index));
+		}
+		build_cells(0);
+		for (auto& task : tasks) {
+			task.get();
+		}
+	}
+
+	template <typename Weight>
+	std::vector<VertexId> PartitionedRouter<Weight>::FindBoundaryVertices(CellId cell) const {
+		// Вершина граничная, если из неё есть ребро в другую ячейку или в неё — из другой
+		const auto& vertices = cells_[cell].vertices;
+		std::vector<bool> is_boundary(vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			for (const EdgeId edge_id : graph_.GetIncidentEdges(vertices[i])) {
+				is_boundary[i] = is_boundary[i] || cell_of_vertex_[graph_.GetEdge(edge_id).to] != cell;
+			}
+			for (const EdgeId edge_id : graph_.GetIncomingEdges(vertices[i])) {
+				is_boundary[i] = is_boundary[i] || cell_of_vertex_[graph_.GetEdge(edge_id).from] != cell;
+			}
+		}
+
+		std::vector<VertexId> boundary_vertices;
+		for (size_t i = 0; i < is_boundary.size(); ++i) {
+			if (is_boundary[i]) {
+				boundary_vertices.push_back(vertices[i]);
+			}
+		}
+		return boundary_vertices;
+	}
+
+	template <typename Weight>
+	void PartitionedRouter<Weight>::BuildTrees(CellId cell, Dijkstra<Weight>& dijkstra) {
+		Cell& cell_data = cells_[cell];
+		const size_t cell_size = cell_data.vertices.size();
+		cell_data.trees.assign(cell_data.boundary_vertices.size(),
+			BoundaryTree{ std::vector<Weight>(cell_size, UnreachableWeight<Weight>()), std::vector<PrevEdgeId>(cell_size, NO_EDGE) });
+
+		for (size_t i = 0; i < cell_data.boundary_vertices.size(); ++i) {
+			dijkstra.Run(cell_data.boundary_vertices[i], std::nullopt, [this, cell](EdgeId edge_id) {
+				return IsInCell(edge_id, cell);
+				});
+			BoundaryTree& tree = cell_data.trees[i];
+			for (const VertexId vertex : dijkstra.GetReachedVertices()) {
+				const size_t local_index = local_index_[vertex];
+				tree.weights[local_index] = dijkstra.GetWeight(vertex);
+				if (const auto prev_edge = dijkstra.GetPrevEdge(vertex)) {
+					if (*prev_edge >= NO_EDGE) {
+						throw std::length_error("Too many edges for the partition tables");
+					}
+					tree.prev_edges[local_index] = static_cast<PrevEdgeId>(*prev_edge);
+				}
+			}
+		}
+	}
+
+	template <typename Weight>
+	void PartitionedRouter<Weight>::RebuildCell(CellId cell) {
+		Cell& cell_data = cells_.at(cell);
+		for (const VertexId vertex : cell_data.boundary_vertices) {
+			boundary_index_[vertex] = NO_BOUNDARY;
+		}
+		cell_data.boundary_vertices = FindBoundaryVertices(cell);
+		for (size_t i = 0; i < cell_data.boundary_vertices.size(); ++i) {
+			boundary_index_[cell_data.boundary_vertices[i]] = i;
+		}
+		Dijkstra<Weight> dijkstra(graph_);
+		BuildTrees(cell, dijkstra);
+	}
+
+	template <typename Weight>
+	size_t PartitionedRouter<Weight>::CountBoundaryVertices(const Graph& graph, const std::vector<CellId>& cell_of_vertex) {
+		std::vector<bool> is_boundary(graph.GetVertexCount());
+		for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+			for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+				const VertexId to = graph.GetEdge(edge_id).to;
+				if (cell_of_vertex.at(to) != cell_of_vertex.at(vertex)) {
+					is_boundary[vertex] = true;
+					is_boundary[to] = true;
+				}
+			}
+		}
+		return static_cast<size_t>(std::count(is_boundary.begin(), is_boundary.end(), true));
+	}
+
+	template <typename Weight>
+	size_t PartitionedRouter<Weight>::GetBoundaryVertexCount() const {
+		size_t count = 0;
+		for (const Cell& cell : cells_) {
+			count += cell.boundary_vertices.size();
+		}
+		return count;
+	}
+
+	template <typename Weight>
+	size_t PartitionedRouter<Weight>::GetMemoryUsage() const {
+		size_t bytes = cell_of_vertex_.size() * (sizeof(CellId) + 2 * sizeof(size_t) + sizeof(OverlayState));
+		for (const Cell& cell : cells_) {
+			bytes += (cell.vertices.size() + cell.boundary_vertices.size()) * sizeof(VertexId)
+				+ cell.trees.size() * cell.vertices.size() * (sizeof(Weight) + sizeof(PrevEdgeId));
+		}
+		return bytes;
+	}
+
+	template <typename Weight>
+	void PartitionedRouter<Weight>::AppendTreePathReversed(const BoundaryTree& tree, VertexId vertex,
+		std::vector<EdgeId>& edges) const {
+		for (PrevEdgeId edge_id = tree.prev_edges[local_index_[vertex]]; edge_id != NO_EDGE;
+			edge_id = tree.prev_edges[local_index_[graph_.GetEdge(edge_id).from]]) {
+			edges.push_back(edge_id);
+		}
+	}
+
+	template <typename Weight>
+	void PartitionedRouter<Weight>::PushOverlay(VertexId vertex, Weight weight, OverlayStep step, size_t prev) const {
+		auto& state = overlay_states_[vertex];
+		// Вес, не поместившийся в тип, насыщен до недостижимого: такой шаг не проходится
+		if (!(weight < UnreachableWeight<Weight>()) || (state.run == overlay_run_ && !(weight < state.weight))) {
+			return;
+		}
+		state = OverlayState{ weight, step, prev, overlay_run_ };
+		overlay_queue_.push_back({ weight, vertex });
+		std::push_heap(overlay_queue_.begin(), overlay_queue_.end(), std::greater<QueueItem>{});
+	}
+
+	template <typename Weight>
+	template <typename EdgeVisitor>
+	std::optional<Weight> PartitionedRouter<Weight>::ForEachRouteEdge(VertexId from, VertexId to, EdgeVisitor&& visitor) const {
+		if (from >= cell_of_vertex_.size() || to >= cell_of_vertex_.size()) {
+			throw std::out_of_range("Vertex is out of range");
+		}
+		const CellId from_cell = cell_of_vertex_[from];
+		const CellId to_cell = cell_of_vertex_[to];
+
+		local_search_.Run(from, std::nullopt, [this, from_cell](EdgeId edge_id) {
+			return IsInCell(edge_id, from_cell);
+			});
+
+		// Лучший найденный маршрут: целиком внутри начальной ячейки
+		// либо через последнюю граничную вершину ячейки конца
+		std::optional<Weight> best_weight;
+		std::optional<VertexId> best_boundary;
+		if (from_cell == to_cell && local_search_.IsReached(to)) {
+			best_weight = local_search_.GetWeight(to);
+		}
+
+		++overlay_run_;
+		overlay_queue_.clear();
+		for (const VertexId vertex : cells_[from_cell].boundary_vertices) {
+			if (local_search_.IsReached(vertex)) {
+				PushOverlay(vertex, local_search_.GetWeight(vertex), OverlayStep::Source, 0);
+			}
+		}
+
+		while (!overlay_queue_.empty()) {
+			std::pop_heap(overlay_queue_.begin(), overlay_queue_.end(), std::greater<QueueItem>{});
+			const auto [weight, vertex] = overlay_queue_.back();
+			overlay_queue_.pop_back();
+			if (overlay_states_[vertex].weight < weight) {
+				continue;
+			}
+			if (best_weight && !(weight < *best_weight)) {
+				break;
+			}
+
+			const CellId cell = cell_of_vertex_[vertex];
+			const BoundaryTree& tree = GetTree(vertex);
+			if (cell == to_cell) {
+				const Weight to_weight = AddWeights(weight, tree.weights[local_index_[to]]);
+				if (to_weight < UnreachableWeight<Weight>() && (!best_weight || to_weight < *best_weight)) {
+					best_weight = to_weight;
+					best_boundary = vertex;
+				}
+			}
+			for (const VertexId boundary_vertex : cells_[cell].boundary_vertices) {
+				const Weight cell_weight = tree.weights[local_index_[boundary_vertex]];
+				if (boundary_vertex != vertex && cell_weight < UnreachableWeight<Weight>()) {
+					PushOverlay(boundary_vertex, AddWeights(weight, cell_weight), OverlayStep::Cell, vertex);
+				}
+			}
+			for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+				const auto& edge = graph_.GetEdge(edge_id);
+				if (cell_of_vertex_[edge.to] != cell) {
+					PushOverlay(edge.to, AddWeights(weight, edge.weight), OverlayStep::Edge, edge_id);
+				}
+			}
+		}
+
+		if (!best_weight) {
+			return std::nullopt;
+		}
+
+		// Маршрут восстанавливается с конца: спуск по таблице, шаги оверлея, локальный поиск.
+		// Буфер общий для запросов и после первых запросов не перевыделяется
+		std::vector<EdgeId>& edges = route_edges_;
+		edges.clear();
+		VertexId vertex = to;
+		if (best_boundary) {
+			AppendTreePathReversed(GetTree(*best_boundary), to, edges);
+			vertex = *best_boundary;
+			while (overlay_states_[vertex].step != OverlayStep::Source) {
+				const auto& state = overlay_states_[vertex];
+				if (state.step == OverlayStep::Edge) {
+					edges.push_back(state.prev);
+					vertex = graph_.GetEdge(state.prev).from;
+				}
+				else {
+					AppendTreePathReversed(GetTree(state.prev), vertex, edges);
+					vertex = state.prev;
+				}
+			}
+		}
+		const size_t source_begin = edges.size();
+		local_search_.ForEachPathEdge(vertex, [&edges](EdgeId edge_id) {
+			edges.push_back(edge_id);
+			});
+		std::reverse(edges.begin() + source_begin, edges.end());
+
+		for (auto it = edges.rbegin(); it != edges.rend(); ++it) {
+			visitor(*it);
+		}
+		return best_weight;
+	}
+
+} // namespace graph
@@ -0,0 +1,71 @@
+#include "route_cache.h"
+
+#include <functional>
+
+size_t RouteCacheKeyHasher::operator()(const RouteCacheKey& key) const
+{
+    std::hash<const Stop*> ptr_hasher;
+    size_t hash = ptr_hasher(key.from);
+    hash = hash * 37 + ptr_hasher(key.to);
+    hash = hash * 37 + std::hash<int>{}(key.bus_wait_time);
+    hash = hash * 37 + std::hash<double>{}(key.bus_velocity);
+    return hash;
+}
+
+const CachedRoute* RouteCache::Find(const RouteCacheKey& key, uint64_t catalogue_version)
+{
+    if (catalogue_version != catalogue_version_)
+    {
+        Clear();
+        catalogue_version_ = catalogue_version;
+    }
+
+    auto it = index_.find(key);
+    if (it == index_.end())
+    {
+        ++stats_.misses;
+        return nullptr;
+    }
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+}
+
+void RouteCache::Insert(const RouteCacheKey& key, CachedRoute route)
+{
+    if (capacity_ == 0)
+    {
+        return;
+    }
+    if (auto it = index_.find(key); it != index_.end())
+    {
+        it->second->second = std::move(route);
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+    entries_.emplace_front(key, std::move(route));
+    index_[key] = entries_.begin();
+    EvictExcess();
+}
+
+void RouteCache::Clear()
+{
+    entries_.clear();
+    index_.clear();
+}
+
+void RouteCache::SetCapacity(size_t capacity)
+{
+    capacity_ = capacity;
+    EvictExcess();
+}
+
+void RouteCache::EvictExcess()
+{
+    while (entries_.size() > capacity_)
+    {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+        ++stats_.evictions;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+// Ключ ответа на запрос Route: пара остановок и настройки, с которыми строился маршрут
+struct RouteCacheKey
+{
+    const Stop* from;
+    const Stop* to;
+    int bus_wait_time;
+    double bus_velocity;
+
+    bool operator==(const RouteCacheKey& other) const
+    {
+        return from == other.from && to == other.to
+            && bus_wait_time == other.bus_wait_time && bus_velocity == other.bus_velocity;
+    }
+};
+
+class RouteCacheKeyHasher
+{
+public:
+    size_t operator()(const RouteCacheKey& key) const;
+};
+
+struct RouteCacheStats
+{
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+};
+
+// Ответ на Route без request_id, уже выведенный в текст JSON: значения ключей "items"
+// и "total_time". Пустой items — маршрут не найден
+struct CachedRoute
+{
+    std::string items;
+    std::string total_time;
+};
+
+// Ограниченный LRU-кеш готовых ответов. Текст не зависит от request_id, поэтому ответ
+// на повторный запрос собирается из готовых кусков без вывода заново.
+// Сбрасывается при любом изменении каталога, которое отслеживается по его версии
+class RouteCache
+{
+public:
+    explicit RouteCache(size_t capacity = 4096) : capacity_(capacity) {}
+
+    const CachedRoute* Find(const RouteCacheKey& key, uint64_t catalogue_version);
+    void Insert(const RouteCacheKey& key, CachedRoute route);
+    void Clear();
+
+    void SetCapacity(size_t capacity);
+    size_t GetCapacity() const { return capacity_; }
+    const RouteCacheStats& GetStats() const { return stats_; }
+
+private:
+    using Entry = std::pair<RouteCacheKey, CachedRoute>;
+
+    void EvictExcess();
+
+    size_t capacity_;
+    uint64_t catalogue_version_ = 0;
+    std::list<Entry> entries_;
+    std::unordered_map<RouteCacheKey, std::list<Entry>::iterator, RouteCacheKeyHasher> index_;
+    RouteCacheStats stats_;
+};
@@ -1,11 +1,13 @@
 #pragma once
 
+#include "dijkstra.h"
 #include "graph.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -22,6 +24,10 @@ namespace graph {
 	public:
 		explicit Router(const Graph& graph);
 
+		// Сколько байт займёт таблица маршрутов для графа с vertex_count вершинами;
+		// позволяет отказаться от построения до того, как память будет выделена
+		static size_t EstimateMemoryUsage(size_t vertex_count);
+
 		struct RouteInfo {
 			Weight weight;
 			std::vector<EdgeId> edges;
@@ -29,89 +35,207 @@ namespace graph {
 
 		std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+		// Передаёт рёбра маршрута посетителю в порядке следования, не выделяя память.
+		// Возвращает вес маршрута или nullopt, если маршрута нет
+		template <typename EdgeVisitor>
+		std::optional<Weight> ForEachRouteEdge(VertexId from, VertexId to, EdgeVisitor&& visitor) const;
+
+		// Инкрементальное обновление таблицы после изменения графа.
+		// Рёбра добавлены или их веса уменьшились: таблица доводится через концы этих рёбер,
+		// O(V^2) на каждую различную вершину-конец, а не на каждое ребро
+		void RelaxEdges(const std::vector<EdgeId>& edge_ids);
+		// Рёбра удалены или их вес увеличился: заново считаются только строки таблицы,
+		// в чьих деревьях кратчайших путей участвуют эти рёбра
+		void RebuildRoutesUsingEdges(const std::vector<EdgeId>& edge_ids);
+
 	private:
-		struct RouteInternalData {
-			Weight weight;
-			std::optional<EdgeId> prev_edge;
-		};
-		using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+		// Таблица V x V хранится двумя плоскими массивами — весов и последних рёбер маршрута.
+		// Строка таблицы лежит в непрерывной памяти, поэтому внутренний цикл релаксации
+		// векторизуется, а ячейка с 32-битным весом занимает 8 байт
+		using PrevEdgeId = std::uint32_t;
+		static constexpr PrevEdgeId NO_EDGE = std::numeric_limits<PrevEdgeId>::max();
+
+		static PrevEdgeId ToPrevEdgeId(EdgeId edge_id) {
+			if (edge_id >= NO_EDGE) {
+				throw std::length_error("Too many edges for the routes table");
+			}
+			return static_cast<PrevEdgeId>(edge_id);
+		}
+
+		size_t GetCellIndex(VertexId from, VertexId to) const {
+			return from * vertex_count_ + to;
+		}
 
 		void InitializeRoutesInternalData(const Graph& graph) {
-			const size_t vertex_count = graph.GetVertexCount();
-			for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-				routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
+			for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+				weights_[GetCellIndex(vertex, vertex)] = ZERO_WEIGHT;
 				for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
 					const auto& edge = graph.GetEdge(edge_id);
 					if (edge.weight < ZERO_WEIGHT) {
 						throw std::domain_error("Edges' weights should be non-negative");
 					}
-					auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-					if (!route_internal_data || route_internal_data->weight > edge.weight) {
-						route_internal_data = RouteInternalData{ edge.weight, edge_id };
+					const size_t cell = GetCellIndex(vertex, edge.to);
+					if (edge.weight < weights_[cell]) {
+						weights_[cell] = edge.weight;
+						prev_edges_[cell] = ToPrevEdgeId(edge_id);
 					}
 				}
 			}
 		}
 
-		void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-			const RouteInternalData& route_to) {
-			auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-			const Weight candidate_weight = route_from.weight + route_to.weight;
-			if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-				route_relaxing = { candidate_weight,
-				route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
+		// Улучшает строку vertex_from маршрутами «путь весом weight_from, затем маршрут
+		// из строки through». Цикл без ветвлений, чтобы компилятор его векторизовал
+		void RelaxRow(VertexId vertex_from, Weight weight_from, PrevEdgeId prev_edge_from,
+			const Weight* weights_through, const PrevEdgeId* prev_edges_through) {
+			Weight* weights = &weights_[GetCellIndex(vertex_from, 0)];
+			PrevEdgeId* prev_edges = &prev_edges_[GetCellIndex(vertex_from, 0)];
+			for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+				const Weight candidate_weight = AddWeights(weight_from, weights_through[vertex_to]);
+				const PrevEdgeId candidate_prev_edge =
+					prev_edges_through[vertex_to] != NO_EDGE ? prev_edges_through[vertex_to] : prev_edge_from;
+				const bool is_better = candidate_weight < weights[vertex_to];
+				weights[vertex_to] = is_better ? candidate_weight : weights[vertex_to];
+				prev_edges[vertex_to] = is_better ? candidate_prev_edge : prev_edges[vertex_to];
 			}
 		}
 
-		void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-			for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-				if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-					for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-						if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-							RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-						}
-					}
+		void RelaxRoutesInternalDataThroughVertex(VertexId vertex_through) {
+			const Weight* weights_through = &weights_[GetCellIndex(vertex_through, 0)];
+			const PrevEdgeId* prev_edges_through = &prev_edges_[GetCellIndex(vertex_through, 0)];
+			for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+				const size_t cell = GetCellIndex(vertex_from, vertex_through);
+				// Строка самой вершины через неё не улучшается
+				if (vertex_from == vertex_through || !(weights_[cell] < UNREACHABLE)) {
+					continue;
 				}
+				RelaxRow(vertex_from, weights_[cell], prev_edges_[cell], weights_through, prev_edges_through);
 			}
 		}
 
+		std::optional<EdgeId> GetPrevEdge(VertexId from, VertexId to) const {
+			const PrevEdgeId edge_id = prev_edges_[GetCellIndex(from, to)];
+			return edge_id != NO_EDGE ? std::optional<EdgeId>(edge_id) : std::nullopt;
+		}
+
 		static constexpr Weight ZERO_WEIGHT{};
+		static constexpr Weight UNREACHABLE = UnreachableWeight<Weight>();
 		const Graph& graph_;
-		RoutesInternalData routes_internal_data_;
+		size_t vertex_count_;
+		std::vector<Weight> weights_;
+		std::vector<PrevEdgeId> prev_edges_;
 	};
 
 	template <typename Weight>
 	Router<Weight>::Router(const Graph& graph)
 		: graph_(graph)
-		, routes_internal_data_(graph.GetVertexCount(),
-			std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+		, vertex_count_(graph.GetVertexCount())
+		, weights_(vertex_count_ * vertex_count_, UNREACHABLE)
+		, prev_edges_(vertex_count_ * vertex_count_, NO_EDGE)
 	{
 		InitializeRoutesInternalData(graph);
 
-		const size_t vertex_count = graph.GetVertexCount();
-		for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-			RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+		for (VertexId vertex_through = 0; vertex_through < vertex_count_; ++vertex_through) {
+			RelaxRoutesInternalDataThroughVertex(vertex_through);
+		}
+	}
+
+	template <typename Weight>
+	size_t Router<Weight>::EstimateMemoryUsage(size_t vertex_count) {
+		return vertex_count * vertex_count * (sizeof(Weight) + sizeof(PrevEdgeId));
+	}
+
+	template <typename Weight>
+	void Router<Weight>::RelaxEdges(const std::vector<EdgeId>& edge_ids) {
+		// Новый кратчайший путь — старые пути таблицы, соединённые новыми рёбрами, поэтому
+		// все его промежуточные точки стыка — концы новых рёбер. Флойд–Уоршелл только по этим
+		// вершинам, начатый с таблицы, куда записаны сами рёбра, находит все такие пути.
+		// У автобуса на n остановок n^2 рёбер, но лишь до 2n различных концов
+		std::vector<VertexId> endpoints;
+		endpoints.reserve(edge_ids.size() * 2);
+		for (const EdgeId edge_id : edge_ids) {
+			const auto& edge = graph_.GetEdge(edge_id);
+			if (edge.weight < ZERO_WEIGHT) {
+				throw std::domain_error("Edges' weights should be non-negative");
+			}
+			const size_t cell = GetCellIndex(edge.from, edge.to);
+			if (edge.weight < weights_[cell]) {
+				weights_[cell] = edge.weight;
+				prev_edges_[cell] = ToPrevEdgeId(edge_id);
+			}
+			endpoints.push_back(edge.from);
+			endpoints.push_back(edge.to);
+		}
+		std::sort(endpoints.begin(), endpoints.end());
+		endpoints.erase(std::unique(endpoints.begin(), endpoints.end()), endpoints.end());
+
+		for (const VertexId vertex_through : endpoints) {
+			RelaxRoutesInternalDataThroughVertex(vertex_through);
+		}
+	}
+
+	template <typename Weight>
+	void Router<Weight>::RebuildRoutesUsingEdges(const std::vector<EdgeId>& edge_ids) {
+		std::vector<bool> is_changed(graph_.GetEdgeCount());
+		for (const EdgeId edge_id : edge_ids) {
+			is_changed.at(edge_id) = true;
+		}
+
+		Dijkstra<Weight> dijkstra(graph_);
+		for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+			Weight* weights = &weights_[GetCellIndex(vertex_from, 0)];
+			PrevEdgeId* prev_edges = &prev_edges_[GetCellIndex(vertex_from, 0)];
+			const bool is_affected = std::any_of(prev_edges, prev_edges + vertex_count_,
+				[&is_changed](PrevEdgeId prev_edge) {
+					return prev_edge != NO_EDGE && is_changed[prev_edge];
+				});
+			if (!is_affected) {
+				continue;
+			}
+
+			dijkstra.Run(vertex_from);
+			for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+				if (dijkstra.IsReached(vertex_to)) {
+					const auto prev_edge = dijkstra.GetPrevEdge(vertex_to);
+					weights[vertex_to] = dijkstra.GetWeight(vertex_to);
+					prev_edges[vertex_to] = prev_edge ? ToPrevEdgeId(*prev_edge) : NO_EDGE;
+				}
+				else {
+					weights[vertex_to] = UNREACHABLE;
+					prev_edges[vertex_to] = NO_EDGE;
+				}
+			}
 		}
 	}
 
 	template <typename Weight>
 	std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
 		VertexId to) const {
-		const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-		if (!route_internal_data) {
-			return std::nullopt;
-		}
-		const Weight weight = route_internal_data->weight;
 		std::vector<EdgeId> edges;
-		for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-			edge_id;
-			edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
-		{
-			edges.push_back(*edge_id);
+		const auto weight = ForEachRouteEdge(from, to, [&edges](EdgeId edge_id) {
+			edges.push_back(edge_id);
+			});
+		if (!weight) {
+			return std::nullopt;
 		}
-		std::reverse(edges.begin(), edges.end());
 
-		return RouteInfo{ weight, std::move(edges) };
+		return RouteInfo{ *weight, std::move(edges) };
+	}
+
+	template <typename Weight>
+	template <typename EdgeVisitor>
+	std::optional<Weight> Router<Weight>::ForEachRouteEdge(VertexId from, VertexId to, EdgeVisitor&& visitor) const {
+		if (from >= vertex_count_ || to >= vertex_count_) {
+			throw std::out_of_range("Vertex is out of range");
+		}
+		const size_t cell = GetCellIndex(from, to);
+		if (!(weights_[cell] < UNREACHABLE)) {
+			return std::nullopt;
+		}
+		// Цепочка предыдущих рёбер идёт от конца маршрута
+		VisitEdgeChain(GetPrevEdge(from, to), [this, from](EdgeId edge_id) {
+			return GetPrevEdge(from, graph_.GetEdge(edge_id).from);
+			}, visitor);
+		return weights_[cell];
 	}
 
 } // namespace graph
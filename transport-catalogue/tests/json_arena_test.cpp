@@ -0,0 +1,146 @@
+// Документ, разобранный в арену, совпадает с тем, что строит json::Load: те же значения,
+// те же ключи и та же расшифровка экранированных строк. На ошибочном входе оба разбора
+// бросают json::ParsingError.
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -I. -o json_arena_test
+//       tests/json_arena_test.cpp json.cpp json_arena.cpp json_builder.cpp
+#include "../json.h"
+#include "../json_arena.h"
+
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const std::vector<std::string> DOCUMENTS = {
+        "null",
+        "  42  ",
+        "-1.5e3",
+        "\"plain\"",
+        "\"escaped \\\"quotes\\\" and \\\\ slash\\n\\t\"",
+        "[]",
+        "{}",
+        "[1, 2.5, true, false, null, \"x\", [], {}]",
+        "{\"b\": 1, \"a\": [\"Stop 1\", \"Stop 2\"], \"c\": {\"nested\": {\"deep\": [null]}}}",
+        "{\"type\": \"Stop\", \"name\": \"Tolstopaltsevo\", \"latitude\": 55.611087, \"longitude\": 37.20829, "
+        "\"road_distances\": {\"Marushkino\": 3900}}",
+        "{\"escaped \\\"key\\\"\": \"value\", \"\": \"\"}",
+    };
+
+    const std::vector<std::string> MALFORMED_DOCUMENTS = {
+        "",
+        "[1, 2",
+        "{\"a\" 1}",
+        "{\"a\": 1, \"a\": 2}",
+        "\"unterminated",
+        "[tru]",
+    };
+
+    // Случайный документ: вложенные массивы и словари со скалярами и строками разной длины
+    std::string MakeDocument(std::mt19937& random, int depth)
+    {
+        switch (random() % (depth > 3 ? 4 : 6))
+        {
+        case 0:
+            return std::to_string(static_cast<int>(random() % 2000001) - 1000000);
+        case 1:
+            return std::to_string(static_cast<double>(random() % 100000) / 7.0);
+        case 2:
+            return random() % 2 ? "true" : "null";
+        case 3:
+        {
+            std::string text = "\"";
+            for (size_t i = 0, size = random() % 40; i < size; ++i)
+            {
+                text += random() % 10 == 0 ? std::string("\\n") : std::string(1, static_cast<char>('a' + random() % 26));
+            }
+            return text + "\"";
+        }
+        case 4:
+        {
+            std::string text = "[";
+            for (size_t i = 0, size = random() % 5; i < size; ++i)
+            {
+                text += (i ? ", " : "") + MakeDocument(random, depth + 1);
+            }
+            return text + "]";
+        }
+        default:
+        {
+            std::string text = "{";
+            for (size_t i = 0, size = random() % 5; i < size; ++i)
+            {
+                text += (i ? ", \"" : "\"") + std::to_string(random() % 100) + "_" + std::to_string(i) + "\": "
+                    + MakeDocument(random, depth + 1);
+            }
+            return text + "}";
+        }
+        }
+    }
+
+    bool CheckSameDocument(const std::string& text)
+    {
+        const json::Node expected = json::Load(std::string_view(text)).GetRoot();
+        const json::ArenaDocument from_text = json::LoadArena(text);
+        std::istringstream input(text);
+        const json::ArenaDocument from_stream = json::LoadArena(input);
+        if (json::ToNode(from_text.GetRoot()) != expected || json::ToNode(from_stream.GetRoot()) != expected)
+        {
+            std::cout << "Different documents for " << text << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool CheckBothFail(const std::string& text)
+    {
+        bool is_load_failed = false;
+        bool is_arena_failed = false;
+        try
+        {
+            json::Load(std::string_view(text));
+        }
+        catch (const json::ParsingError&)
+        {
+            is_load_failed = true;
+        }
+        try
+        {
+            json::LoadArena(text);
+        }
+        catch (const json::ParsingError&)
+        {
+            is_arena_failed = true;
+        }
+        if (!is_load_failed || !is_arena_failed)
+        {
+            std::cout << "Expected both parses to fail for " << text << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    bool is_ok = true;
+    for (const auto& text : DOCUMENTS)
+    {
+        is_ok = CheckSameDocument(text) && is_ok;
+    }
+    std::mt19937 random(1);
+    for (int i = 0; i < 1000; ++i)
+    {
+        is_ok = CheckSameDocument(MakeDocument(random, 0)) && is_ok;
+    }
+    for (const auto& text : MALFORMED_DOCUMENTS)
+    {
+        is_ok = CheckBothFail(text) && is_ok;
+    }
+
+    std::cout << (is_ok ? "OK" : "FAILED") << std::endl;
+    return is_ok ? 0 : 1;
+}
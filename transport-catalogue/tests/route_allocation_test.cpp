@@ -0,0 +1,187 @@
+// Ответ на запрос Route в установившемся режиме не выделяет памяти: ни при обходе маршрута
+// роутером, ни при выводе ответа. Повторный проход по тем же запросам должен обойтись
+// без единого вызова operator new для каждого способа маршрутизации.
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -pthread -I. -o route_allocation_test
+//       tests/route_allocation_test.cpp $(ls *.cpp | grep -v main.cpp)
+#include "../json_reader.h"
+#include "../transport_catalogue.h"
+#include "../transport_router.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Считаются только выделения потока, который проверяется: роутер строится в фоне
+    thread_local bool is_counting = false;
+    thread_local size_t allocation_count = 0;
+
+    struct AllocationCounter
+    {
+        AllocationCounter()
+        {
+            allocation_count = 0;
+            is_counting = true;
+        }
+        ~AllocationCounter()
+        {
+            is_counting = false;
+        }
+        size_t Get() const
+        {
+            return allocation_count;
+        }
+    };
+}
+
+void* operator new(size_t size)
+{
+    if (is_counting)
+    {
+        ++allocation_count;
+    }
+    if (void* pointer = std::malloc(size == 0 ? 1 : size))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+namespace
+{
+    constexpr size_t STOP_COUNT = 60;
+    constexpr size_t BUS_COUNT = 12;
+    constexpr size_t STOPS_PER_BUS = 8;
+
+    std::string StopName(size_t index)
+    {
+        return "Stop " + std::to_string(index);
+    }
+
+    std::vector<std::pair<size_t, size_t>> MakeRoutePairs()
+    {
+        std::vector<std::pair<size_t, size_t>> pairs;
+        for (size_t from = 0; from < STOP_COUNT; from += 3)
+        {
+            for (size_t to = 1; to < STOP_COUNT; to += 4)
+            {
+                pairs.push_back({ from, to });
+            }
+        }
+        return pairs;
+    }
+
+    // Документ с синтетической сетью и round_count одинаковыми проходами по парам остановок
+    std::string MakeDocument(const std::string& routing_extra, size_t round_count, bool has_disruption)
+    {
+        std::ostringstream document;
+        document << "{\"base_requests\": [";
+        for (size_t i = 0; i < STOP_COUNT; ++i)
+        {
+            document << (i ? ", " : "") << "{\"type\": \"Stop\", \"name\": \"" << StopName(i) << "\", "
+                << "\"latitude\": " << 55.5 + (i % 10) * 0.01 << ", \"longitude\": " << 37.5 + (i / 10) * 0.01 << ", "
+                << "\"road_distances\": {\"" << StopName((i + 1) % STOP_COUNT) << "\": " << 400 + i * 37 % 900 << "}}";
+        }
+        for (size_t bus = 0; bus < BUS_COUNT; ++bus)
+        {
+            document << ", {\"type\": \"Bus\", \"name\": \"" << bus << "\", \"is_roundtrip\": false, \"stops\": [";
+            for (size_t i = 0; i < STOPS_PER_BUS; ++i)
+            {
+                document << (i ? ", " : "") << "\"" << StopName((bus * 5 + i * (bus % 3 + 1)) % STOP_COUNT) << "\"";
+            }
+            document << "]}";
+        }
+        document << "], \"render_settings\": {\"width\": 600, \"height\": 400, \"padding\": 50, \"line_width\": 14, "
+            << "\"stop_radius\": 5, \"bus_label_font_size\": 20, \"bus_label_offset\": [7, 15], "
+            << "\"stop_label_font_size\": 20, \"stop_label_offset\": [7, -3], \"underlayer_color\": \"white\", "
+            << "\"underlayer_width\": 3, \"color_palette\": [\"green\", \"red\"]}, "
+            << "\"routing_settings\": {\"bus_wait_time\": 6, \"bus_velocity\": 40" << routing_extra << "}, "
+            << "\"stat_requests\": [";
+        int id = 1;
+        if (has_disruption)
+        {
+            document << "{\"type\": \"Disruption\", \"id\": " << id++ << ", \"suspend_buses\": [\"3\"], "
+                << "\"suspend_stops\": [\"" << StopName(7) << "\"]}";
+        }
+        const auto pairs = MakeRoutePairs();
+        for (size_t round = 0; round < round_count; ++round)
+        {
+            for (const auto& [from, to] : pairs)
+            {
+                document << (id > 1 ? ", " : "") << "{\"type\": \"Route\", \"id\": " << id << ", "
+                    << "\"from\": \"" << StopName(from) << "\", \"to\": \"" << StopName(to) << "\"}";
+                ++id;
+            }
+        }
+        document << "]}";
+        return document.str();
+    }
+
+    size_t CountRequestAllocations(const std::string& document_text)
+    {
+        TransportCatalogue catalogue;
+        std::istringstream input(document_text);
+        std::ostringstream output;
+        InformationProcessing processor(catalogue, input, output);
+        std::FILE* null_output = std::fopen("/dev/null", "w");
+        processor.SetOutputDescriptor(fileno(null_output));
+        processor.Process();
+
+        size_t allocations = 0;
+        {
+            AllocationCounter counter;
+            processor.ProcessRequest();
+            allocations = counter.Get();
+        }
+        std::fclose(null_output);
+        return allocations;
+    }
+
+    // Выделения второго прохода по тем же запросам: разница между документами с двумя и одним проходом
+    bool CheckSteadyStateAllocations(const std::string& name, const std::string& routing_extra, bool has_disruption)
+    {
+        const size_t one_round = CountRequestAllocations(MakeDocument(routing_extra, 1, has_disruption));
+        const size_t two_rounds = CountRequestAllocations(MakeDocument(routing_extra, 2, has_disruption));
+        const size_t extra = two_rounds > one_round ? two_rounds - one_round : 0;
+        std::cout << name << ": " << extra << " allocations for " << MakeRoutePairs().size() << " repeated Route requests"
+            << std::endl;
+        return extra == 0;
+    }
+}
+
+int main()
+{
+    bool is_ok = true;
+    for (const std::string backend : { "all_pairs", "on_demand", "partitioned" })
+    {
+        // Разбиение мелкой сети почти целиком из границ: ограничение снято, чтобы проверялся сам Partitioned
+        const std::string settings = ", \"router_backend\": \"" + backend + "\", \"router_cell_size\": 10, "
+            "\"router_max_boundary_share\": 1";
+        is_ok = CheckSteadyStateAllocations(backend, settings + ", \"route_cache_size\": 0", false) && is_ok;
+        is_ok = CheckSteadyStateAllocations(backend + " with cache", settings, false) && is_ok;
+        is_ok = CheckSteadyStateAllocations(backend + " with disruption", settings + ", \"route_cache_size\": 0", true)
+            && is_ok;
+    }
+    is_ok = CheckSteadyStateAllocations("on_demand warmed up",
+        ", \"router_backend\": \"on_demand\", \"route_cache_size\": 0, \"warmup_stops\": [\"Stop 0\", \"Stop 3\"]", false)
+        && is_ok;
+
+    std::cout << (is_ok ? "OK" : "FAILED") << std::endl;
+    return is_ok ? 0 : 1;
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+	// Транзитивное замыкание: какие вершины достижимы из каких.
+	// Вершины одной сильно связной компоненты достижимы друг из друга, поэтому замыкание
+	// строится по DAG компонент: строка компоненты — битовое множество достижимых компонент,
+	// объединение строк её преемников по 64 бита за операцию. Компоненты одного уровня DAG
+	// (одной высоты над стоками) друг от друга не зависят и считаются параллельно.
+	// Память — C^2 / 8 байт на C компонент
+	class TransitiveClosure {
+	public:
+		// Рёбра, отвергнутые фильтром, в замыкание не входят; пустой фильтр пропускает все
+		using EdgeFilter = std::function<bool(EdgeId)>;
+
+		template <typename Weight>
+		explicit TransitiveClosure(const DirectedWeightedGraph<Weight>& graph, const EdgeFilter& is_edge_allowed = {},
+			size_t worker_count = std::thread::hardware_concurrency());
+
+		// Вершина достижима из самой себя
+		bool IsReachable(VertexId from, VertexId to) const {
+			const size_t target = components_.at(to);
+			return (GetRow(components_.at(from))[target / WORD_BITS] >> (target % WORD_BITS)) & 1;
+		}
+		size_t GetComponent(VertexId vertex) const { return components_.at(vertex); }
+		size_t GetComponentCount() const { return component_count_; }
+		size_t GetLevelCount() const { return level_count_; }
+
+		struct ReachCounts {
+			// Для каждой вершины: сколько отмеченных вершин достижимо из неё
+			std::vector<size_t> reachable;
+			// и из скольких отмеченных вершин достижима она (сама вершина учитывается в обоих)
+			std::vector<size_t> reaching;
+		};
+		template <typename VertexPredicate>
+		ReachCounts CountReachable(VertexPredicate is_counted) const;
+
+	private:
+		using Word = std::uint64_t;
+		static constexpr size_t WORD_BITS = 64;
+
+		const Word* GetRow(size_t component) const { return rows_.data() + component * words_per_row_; }
+		Word* GetRow(size_t component) { return rows_.data() + component * words_per_row_; }
+
+		template <typename Weight>
+		void FindStrongComponents(const DirectedWeightedGraph<Weight>& graph, const EdgeFilter& is_edge_allowed);
+
+		static size_t CountTrailingZeros(Word word) {
+#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<size_t>(__builtin_ctzll(word));
+#else
+			size_t count = 0;
+			for (; !(word & 1); word >>= 1) {
+				++count;
+			}
+			return count;
+#endif
+		}
+
+		std::vector<size_t> components_;
+		size_t component_count_ = 0;
+		size_t level_count_ = 0;
+		size_t words_per_row_ = 0;
+		std::vector<Word> rows_;
+	};
+
+	template <typename Weight>
+	void TransitiveClosure::FindStrongComponents(const DirectedWeightedGraph<Weight>& graph, const EdgeFilter& is_edge_allowed) {
+		// Алгоритм Тарьяна без рекурсии: компоненты нумеруются в порядке завершения,
+		// так что рёбра между компонентами всегда ведут от большего номера к меньшему
+		const size_t vertex_count = graph.GetVertexCount();
+		constexpr size_t NO_INDEX = static_cast<size_t>(-1);
+		std::vector<size_t> indices(vertex_count, NO_INDEX);
+		std::vector<size_t> low_links(vertex_count);
+		std::vector<bool> is_on_stack(vertex_count);
+		std::vector<VertexId> stack;
+		// Вершина обхода и позиция в её списке инцидентности
+		std::vector<std::pair<VertexId, size_t>> call_stack;
+		size_t next_index = 0;
+		components_.assign(vertex_count, NO_INDEX);
+
+		for (VertexId root = 0; root < vertex_count; ++root) {
+			if (indices[root] != NO_INDEX) {
+				continue;
+			}
+			call_stack.emplace_back(root, 0);
+			while (!call_stack.empty()) {
+				auto& [vertex, position] = call_stack.back();
+				if (position == 0) {
+					indices[vertex] = low_links[vertex] = next_index++;
+					stack.push_back(vertex);
+					is_on_stack[vertex] = true;
+				}
+				const auto edges = graph.GetIncidentEdges(vertex);
+				bool is_descended = false;
+				while (position < static_cast<size_t>(edges.end() - edges.begin())) {
+					const EdgeId edge_id = *(edges.begin() + position++);
+					if (is_edge_allowed && !is_edge_allowed(edge_id)) {
+						continue;
+					}
+					const VertexId next = graph.GetEdge(edge_id).to;
+					if (indices[next] == NO_INDEX) {
+						// Позиция 0 отмечает ещё не открытую вершину, поэтому сдвиг делается до спуска
+						call_stack.emplace_back(next, 0);
+						is_descended = true;
+						break;
+					}
+					if (is_on_stack[next]) {
+						low_links[vertex] = std::min(low_links[vertex], indices[next]);
+					}
+				}
+				if (is_descended) {
+					continue;
+				}
+
+				const VertexId finished = vertex;
+				call_stack.pop_back();
+				if (!call_stack.empty()) {
+					const VertexId parent = call_stack.back().first;
+					low_links[parent] = std::min(low_links[parent], low_links[finished]);
+				}
+				if (low_links[finished] == indices[finished]) {
+					VertexId member;
+					do {
+						member = stack.back();
+						stack.pop_back();
+						is_on_stack[member] = false;
+						components_[member] = component_count_;
+					} while (member != finished);
+					++component_count_;
+				}
+			}
+		}
+	}
+
+	template <typename Weight>
+	TransitiveClosure::TransitiveClosure(const DirectedWeightedGraph<Weight>& graph, const EdgeFilter& is_edge_allowed,
+		size_t worker_count) {
+		FindStrongComponents(graph, is_edge_allowed);
+
+		// Рёбра DAG компонент без повторов
+		std::vector<std::vector<size_t>> successors(component_count_);
+		for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+			for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+				if (is_edge_allowed && !is_edge_allowed(edge_id)) {
+					continue;
+				}
+				const size_t from = components_[vertex];
+				const size_t to = components_[graph.GetEdge(edge_id).to];
+				if (from != to) {
+					successors[from].push_back(to);
+				}
+			}
+		}
+		for (auto& component_successors : successors) {
+			std::sort(component_successors.begin(), component_successors.end());
+			component_successors.erase(std::unique(component_successors.begin(), component_successors.end()),
+				component_successors.end());
+		}
+
+		// Уровень — длина самого длинного пути до стока. Преемники имеют меньшие номера,
+		// поэтому уровни считаются одним проходом по возрастанию номеров
+		std::vector<size_t> levels(component_count_);
+		for (size_t component = 0; component < component_count_; ++component) {
+			for (const size_t successor : successors[component]) {
+				levels[component] = std::max(levels[component], levels[successor] + 1);
+			}
+			level_count_ = std::max(level_count_, levels[component] + 1);
+		}
+		std::vector<std::vector<size_t>> level_components(level_count_);
+		for (size_t component = 0; component < component_count_; ++component) {
+			level_components[levels[component]].push_back(component);
+		}
+
+		words_per_row_ = (component_count_ + WORD_BITS - 1) / WORD_BITS;
+		rows_.assign(component_count_ * words_per_row_, 0);
+		auto build_row = [this, &successors](size_t component) {
+			Word* row = GetRow(component);
+			row[component / WORD_BITS] |= Word{ 1 } << (component % WORD_BITS);
+			for (const size_t successor : successors[component]) {
+				const Word* successor_row = GetRow(successor);
+				for (size_t word = 0; word < words_per_row_; ++word) {
+					row[word] |= successor_row[word];
+				}
+			}
+		};
+
+		// Мелкие уровни дешевле посчитать в текущем потоке, чем раздать потокам
+		constexpr size_t MIN_WORDS_PER_WORKER = size_t{ 1 } << 14;
+		worker_count = std::max<size_t>(worker_count, 1);
+		for (const auto& components : level_components) {
+			const size_t level_workers = std::clamp<size_t>(components.size() * words_per_row_ / MIN_WORDS_PER_WORKER,
+				1, std::min(worker_count, components.size()));
+			auto build_rows = [&components, &build_row, level_workers](size_t worker_index) {
+				for (size_t i = worker_index; i < components.size(); i += level_workers) {
+					build_row(components[i]);
+				}
+			};
+			std::vector<std::future<void>> tasks;
+			for (size_t worker_index = 1; worker_index < level_workers; ++worker_index) {
+				tasks.push_back(std::async(std::launch::async, build_rows, worker_index));
+			}
+			build_rows(0);
+			for (auto& task : tasks) {
+				task.get();
+			}
+		}
+	}
+
+	template <typename VertexPredicate>
+	TransitiveClosure::ReachCounts TransitiveClosure::CountReachable(VertexPredicate is_counted) const {
+		std::vector<size_t> component_sizes(component_count_);
+		for (VertexId vertex = 0; vertex < components_.size(); ++vertex) {
+			if (is_counted(vertex)) {
+				++component_sizes[components_[vertex]];
+			}
+		}
+
+		std::vector<size_t> component_reachable(component_count_);
+		std::vector<size_t> component_reaching(component_count_);
+		for (size_t component = 0; component < component_count_; ++component) {
+			const Word* row = GetRow(component);
+			for (size_t word = 0; word < words_per_row_; ++word) {
+				for (Word bits = row[word]; bits != 0; bits &= bits - 1) {
+					const size_t target = word * WORD_BITS + CountTrailingZeros(bits);
+					component_reachable[component] += component_sizes[target];
+					component_reaching[target] += component_sizes[component];
+				}
+			}
+		}
+
+		ReachCounts counts;
+		counts.reachable.reserve(components_.size());
+		counts.reaching.reserve(components_.size());
+		for (const size_t component : components_) {
+			counts.reachable.push_back(component_reachable[component]);
+			counts.reaching.push_back(component_reaching[component]);
+		}
+		return counts;
+	}
+
+} // namespace graph
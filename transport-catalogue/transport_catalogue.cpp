@@ -2,6 +2,7 @@
 
 void TransportCatalogue::AddStop(const std::string& stop_name, geo::Coordinates coordinates)
 {
+    ++version_;
     stops.push_back({ stop_name, coordinates });
     stopname_to_stop[stops.back().stop_name] = &stops.back();
 }
@@ -18,6 +19,7 @@ Stop* TransportCatalogue::FindStop(std::string_view stop_name) const
 
 void TransportCatalogue::AddBus(const std::string& bus_name, std::vector<std::string_view> stop_names, bool is_roundtrip)
 {
+    ++version_;
     std::vector<Stop*> stops_on_route;
     for (const auto& stop_name : stop_names)
     {
@@ -48,6 +50,28 @@ Bus* TransportCatalogue::FindBus(std::string_view bus_name) const
     return nullptr;
 }
 
+void TransportCatalogue::RemoveBus(std::string_view bus_name)
+{
+    Bus* bus = FindBus(bus_name);
+    if (!bus)
+    {
+        return;
+    }
+    ++version_;
+    for (Stop* stop : bus->bus_stops)
+    {
+        stop_to_buses[stop].erase(bus->bus_name);
+    }
+
+    // Удаление из середины deque инвалидирует указатели, поэтому индекс строится заново
+    busname_to_bus.clear();
+    buses.erase(std::find_if(buses.begin(), buses.end(), [bus](const Bus& other) { return &other == bus; }));
+    for (Bus& other : buses)
+    {
+        busname_to_bus[other.bus_name] = &other;
+    }
+}
+
 const std::set<std::string>* TransportCatalogue::GetBusesByStop(std::string_view stop_name) const
 
 {
@@ -61,6 +85,7 @@ const std::set<std::string>* TransportCatalogue::GetBusesByStop(std::string_view
 
 void TransportCatalogue::AddDistance(const Stop* from, const Stop* to, int distance)
 {
+    ++version_;
     distances_[std::make_pair(from, to)] = distance;
 }
 
@@ -2,6 +2,7 @@
 #include "geo.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <deque>
 #include <unordered_map>
 #include <string>
@@ -43,6 +44,7 @@ public:
 	Stop* FindStop(std::string_view) const;
 	void AddBus(const std::string&, std::vector<std::string_view>, bool);
 	Bus* FindBus(std::string_view) const;
+	void RemoveBus(std::string_view);
 	std::optional<BusInfo> GetBusInfo(const std::string_view) const;
 	const std::set<std::string>* GetBusesByStop(std::string_view) const;
 
@@ -50,6 +52,9 @@ public:
 	int CalculateFullRouteLength(const Bus* bus) const;
 	int RouteLenghtBetweenTwoStops(const Stop*, const Stop*) const;
 
+	// Растёт при каждом изменении каталога; по ней сбрасываются производные кеши
+	uint64_t GetVersion() const { return version_; }
+
 	std::deque<Bus> GetBuses() const { return buses; }
 	std::deque<Stop> GetStops() const {	return stops; }
 
@@ -92,4 +97,5 @@ private:
 	std::unordered_map<std::string_view, Bus*> busname_to_bus;
 	std::unordered_map<Stop*, std::set<std::string>> stop_to_buses;
 	std::unordered_map<std::pair<const Stop*, const Stop*>, int, Hasher> distances_;
+	uint64_t version_ = 0;
 };
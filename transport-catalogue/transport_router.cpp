@@ -1,26 +1,133 @@
 #include "transport_router.h"
 
-TransportRouter::TransportRouter(const TransportCatalogue& catalogue, int bus_wait_time, double bus_velocity)
-    : catalogue_(catalogue), bus_wait_time_(bus_wait_time), bus_velocity_(bus_velocity)
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <tuple>
+
+namespace {
+    // Сотые доли секунды
+    constexpr double ROUTE_WEIGHT_UNITS_PER_MINUTE = 6000.0;
+    // Запас изохроны на ошибку округления весов, не больше полусотой секунды на ребро:
+    // минуты хватает путям до 12000 рёбер
+    constexpr RouteWeight ISOCHRONE_WEIGHT_MARGIN = 6000;
+}
+
+TransportRouter::TransportRouter(const TransportCatalogue& catalogue, int bus_wait_time, double bus_velocity,
+    RouterOptions options)
+    : catalogue_(catalogue), backend_(options.backend), log_metrics_(options.log_metrics)
 {
+    profiles_.push_back(RoutingProfile{ "", bus_wait_time, bus_velocity });
+    profiles_.insert(profiles_.end(), options.profiles.begin(), options.profiles.end());
+    k_shortest_paths_.resize(profiles_.size());
+    searches_.resize(profiles_.size());
+    route_searches_.resize(profiles_.size());
+
+    const auto build_start = std::chrono::steady_clock::now();
     InitializeStops();
     AddBusEdges();
-    router_ = std::make_unique<graph::Router<double>>(graph_);
+    components_ = graph::WeaklyConnectedComponents(graph_);
+
+    // Оценка делается до выделения памяти под таблицу, а не по факту нехватки
+    const size_t table_bytes = graph::Router<RouteWeight>::EstimateMemoryUsage(graph_.GetVertexCount());
+    if (backend_ == RouterBackend::Auto) {
+        backend_ = table_bytes <= options.memory_budget ? RouterBackend::AllPairs : RouterBackend::OnDemand;
+    }
+    if (backend_ == RouterBackend::AllPairs) {
+        router_ = std::make_unique<graph::Router<RouteWeight>>(graph_);
+    }
+    else if (backend_ == RouterBackend::Partitioned) {
+        // Автобус связывает рёбрами каждую пару своих остановок, поэтому остановка любого
+        // маршрута, выходящего из ячейки, становится граничной. Вырожденное разбиение
+        // медленнее поиска без таблиц и при сборке, и на запросах
+        auto cells = SplitIntoCells(std::max<size_t>(options.cell_size, 1));
+        const size_t boundary_count = graph::PartitionedRouter<RouteWeight>::CountBoundaryVertices(graph_, cells);
+        boundary_share_ = graph_.GetVertexCount() > 0 ? static_cast<double>(boundary_count) / graph_.GetVertexCount() : 0.0;
+        if (*boundary_share_ <= options.max_boundary_share) {
+            partitioned_router_ = std::make_unique<graph::PartitionedRouter<RouteWeight>>(graph_, std::move(cells));
+        }
+        else {
+            backend_ = RouterBackend::OnDemand;
+        }
+    }
+
+    const std::chrono::duration<double, std::milli> build_time = std::chrono::steady_clock::now() - build_start;
+    if (log_metrics_) {
+        LogBuildMetrics(options, table_bytes, build_time.count());
+    }
 }
 
 void TransportRouter::InitializeStops() {
     const auto& stops = catalogue_.GetStopNameToStopMap();
     size_t vertex_count = stops.size() * 2;
-    graph_ = graph::DirectedWeightedGraph<double>(vertex_count);
+    graph_ = graph::DirectedWeightedGraph<RouteWeight>(vertex_count);
+    for (size_t profile = 1; profile < profiles_.size(); ++profile) {
+        graph_.AddProfile();
+    }
 
     graph::VertexId vertex_id = 0;
     for (const auto& [stop_name, stop_info] : stops) {
         stop_ids_[stop_name] = vertex_id;
+        stop_names_.push_back(stop_info->stop_name);
 
-        graph_.AddEdge(graph::Edge<double>{stop_info->stop_name, 0, vertex_id, vertex_id + 1, static_cast<double>(bus_wait_time_) });
+        const graph::EdgeId edge_id = graph_.AddEdge(graph::Edge<RouteWeight>{stop_info->stop_name, 0, vertex_id, vertex_id + 1,
+            ToRouteWeight(profiles_[0].bus_wait_time) });
+        for (graph::ProfileId profile = 1; profile < profiles_.size(); ++profile) {
+            graph_.SetEdgeWeight(edge_id, profile, ToRouteWeight(profiles_[profile].bus_wait_time));
+        }
 
         vertex_id += 2;
     }
+    edge_bus_ids_.assign(graph_.GetEdgeCount(), NO_BUS);
+    edge_distances_.assign(graph_.GetEdgeCount(), 0.0);
+    suspended_stops_.assign(stop_names_.size(), false);
+}
+
+std::vector<graph::PartitionedRouter<RouteWeight>::CellId> TransportRouter::SplitIntoCells(size_t cell_size) const {
+    // Остановки делятся пополам по медиане вдоль более протяжённой координаты,
+    // пока в части не останется не больше cell_size остановок: соседние остановки
+    // оказываются в одной ячейке, а рёбер между ячейками получается немного
+    std::vector<std::pair<geo::Coordinates, size_t>> stops;
+    for (size_t i = 0; i < stop_names_.size(); ++i) {
+        stops.push_back({ catalogue_.FindStop(stop_names_[i])->stop_coordinates, i });
+    }
+
+    std::vector<size_t> stop_cells(stops.size());
+    size_t cell_count = 0;
+    auto split = [&](auto& self, auto begin, auto end) -> void {
+        if (static_cast<size_t>(end - begin) <= cell_size) {
+            for (auto it = begin; it != end; ++it) {
+                stop_cells[it->second] = cell_count;
+            }
+            ++cell_count;
+            return;
+        }
+        const auto [min_lat, max_lat] = std::minmax_element(begin, end, [](const auto& lhs, const auto& rhs) {
+            return lhs.first.lat < rhs.first.lat;
+        });
+        const auto [min_lng, max_lng] = std::minmax_element(begin, end, [](const auto& lhs, const auto& rhs) {
+            return lhs.first.lng < rhs.first.lng;
+        });
+        const bool by_lat = max_lat->first.lat - min_lat->first.lat >= max_lng->first.lng - min_lng->first.lng;
+        const auto middle = begin + (end - begin) / 2;
+        std::nth_element(begin, middle, end, [by_lat](const auto& lhs, const auto& rhs) {
+            return by_lat ? lhs.first.lat < rhs.first.lat : lhs.first.lng < rhs.first.lng;
+        });
+        self(self, begin, middle);
+        self(self, middle, end);
+    };
+    split(split, stops.begin(), stops.end());
+
+    // Обе вершины остановки лежат в ячейке остановки
+    std::vector<graph::PartitionedRouter<RouteWeight>::CellId> vertex_cells(graph_.GetVertexCount());
+    for (graph::VertexId vertex = 0; vertex < vertex_cells.size(); ++vertex) {
+        vertex_cells[vertex] = stop_cells[vertex / 2];
+    }
+    return vertex_cells;
 }
 
 void TransportRouter::AddBusEdges() {
@@ -28,81 +135,527 @@ void TransportRouter::AddBusEdges() {
 
     for (const auto& [bus_name, bus_info] : buses) 
     {
-        const auto& stops = bus_info->bus_stops;
-        size_t stop_count = stops.size();
+        AddBusEdges(*bus_info);
+    }
+}
 
-        for (size_t i = 0; i + 1 < stop_count; ++i) 
+std::vector<graph::EdgeId> TransportRouter::AddBusEdges(const Bus& bus) {
+    const auto& stops = bus.bus_stops;
+    size_t stop_count = stops.size();
+    auto& edge_ids = bus_edges_[bus.bus_name];
+
+    for (size_t i = 0; i + 1 < stop_count; ++i) 
+    {
+        for (size_t j = i + 1; j < stop_count; ++j)
         {
-            for (size_t j = i + 1; j < stop_count; ++j)
-            {
-                size_t span_count = j - i;
+            size_t span_count = j - i;
 
-                double total_distance_forward = 0.0;
-                for (size_t k = i + 1; k <= j; ++k) {
-                    total_distance_forward += catalogue_.RouteLenghtBetweenTwoStops(stops[k - 1], stops[k]);
+            double total_distance_forward = 0.0;
+            for (size_t k = i + 1; k <= j; ++k) {
+                total_distance_forward += catalogue_.RouteLenghtBetweenTwoStops(stops[k - 1], stops[k]);
+            }
+
+            edge_ids.push_back(AddTravelEdge(bus.bus_name, span_count, stop_ids_.at(stops[i]->stop_name) + 1,
+                stop_ids_.at(stops[j]->stop_name), total_distance_forward));
+
+            if (!bus.is_roundtrip) {
+                double total_distance_backward = 0.0;
+                for (size_t k = j; k > i; --k) {
+                    total_distance_backward += catalogue_.RouteLenghtBetweenTwoStops(stops[k], stops[k - 1]);
                 }
+                edge_ids.push_back(AddTravelEdge(bus.bus_name, span_count,
+                    stop_ids_.at(stops[j]->stop_name) + 1, stop_ids_.at(stops[i]->stop_name), total_distance_backward));
+            }
+        }
+    }
+    edge_bus_ids_.resize(graph_.GetEdgeCount(), GetBusId(bus.bus_name));
+    return edge_ids;
+}
+
+graph::EdgeId TransportRouter::AddTravelEdge(const std::string& bus_name, size_t span_count, graph::VertexId from,
+    graph::VertexId to, double distance) {
+    auto travel_weight = [distance](const RoutingProfile& profile) {
+        return ToRouteWeight(GetTravelTime(distance, profile));
+    };
+    const graph::EdgeId edge_id = graph_.AddEdge(graph::Edge<RouteWeight>{bus_name, span_count, from, to, travel_weight(profiles_[0])});
+    for (graph::ProfileId profile = 1; profile < profiles_.size(); ++profile) {
+        graph_.SetEdgeWeight(edge_id, profile, travel_weight(profiles_[profile]));
+    }
+    edge_distances_.resize(graph_.GetEdgeCount());
+    edge_distances_[edge_id] = distance;
+    return edge_id;
+}
 
-                double travel_time_forward = total_distance_forward / (bus_velocity_ * (1000.0 / 60.0));
+size_t TransportRouter::GetBusId(const std::string& bus_name) {
+    const auto [it, is_inserted] = bus_ids_.emplace(bus_name, bus_names_.size());
+    if (is_inserted) {
+        bus_names_.push_back(it->first);
+        suspended_buses_.push_back(false);
+    }
+    return it->second;
+}
 
-                graph_.AddEdge(graph::Edge<double>{static_cast<std::string>(bus_name), span_count, stop_ids_.at(stops[i]->stop_name) + 1, 
-                    stop_ids_.at(stops[j]->stop_name), travel_time_forward});
+std::vector<graph::EdgeId> TransportRouter::RemoveBusEdges(std::string_view bus_name) {
+    auto it = bus_edges_.find(std::string(bus_name));
+    if (it == bus_edges_.end()) {
+        return {};
+    }
+
+    std::vector<graph::EdgeId> edge_ids = std::move(it->second);
+    bus_edges_.erase(it);
+    for (const auto edge_id : edge_ids) {
+        graph_.RemoveEdge(edge_id);
+    }
+    return edge_ids;
+}
 
-                if (!bus_info->is_roundtrip) {
-                    double total_distance_backward = 0.0;
-                    for (size_t k = j; k > i; --k) {
-                        total_distance_backward += catalogue_.RouteLenghtBetweenTwoStops(stops[k], stops[k - 1]);
-                    }
-                    double travel_time_backward = total_distance_backward / (bus_velocity_ * (1000.0 / 60.0));
-                    graph_.AddEdge(graph::Edge<double>{static_cast<std::string>(bus_name), span_count, 
-                        stop_ids_.at(stops[j]->stop_name) + 1, stop_ids_.at(stops[i]->stop_name), travel_time_backward});
+void TransportRouter::Update(const std::vector<std::string_view>& bus_names,
+    const std::vector<std::pair<std::string_view, std::string_view>>& distances) {
+    std::vector<std::string> changed_buses(bus_names.begin(), bus_names.end());
+    // Расстояние from->to используется и для обратного перегона, если для него своего нет,
+    // поэтому затронуты все автобусы, где остановки соседствуют в любом порядке
+    for (const auto& [stop_from, stop_to] : distances) {
+        const Stop* from = catalogue_.FindStop(stop_from);
+        const Stop* to = catalogue_.FindStop(stop_to);
+        const auto* buses = catalogue_.GetBusesByStop(stop_from);
+        if (!from || !to || !buses) {
+            continue;
+        }
+        for (const auto& bus_name : *buses) {
+            const auto& stops = catalogue_.FindBus(bus_name)->bus_stops;
+            for (size_t i = 1; i < stops.size(); ++i) {
+                if ((stops[i - 1] == from && stops[i] == to) || (stops[i - 1] == to && stops[i] == from)) {
+                    changed_buses.push_back(bus_name);
+                    break;
                 }
             }
         }
     }
+    std::sort(changed_buses.begin(), changed_buses.end());
+    changed_buses.erase(std::unique(changed_buses.begin(), changed_buses.end()), changed_buses.end());
+
+    std::vector<graph::EdgeId> removed_edges;
+    std::vector<graph::EdgeId> added_edges;
+    for (const auto& bus_name : changed_buses) {
+        const auto bus_removed_edges = RemoveBusEdges(bus_name);
+        removed_edges.insert(removed_edges.end(), bus_removed_edges.begin(), bus_removed_edges.end());
+        if (const Bus* bus = catalogue_.FindBus(bus_name)) {
+            const auto bus_added_edges = AddBusEdges(*bus);
+            added_edges.insert(added_edges.end(), bus_added_edges.begin(), bus_added_edges.end());
+        }
+    }
+    if (!removed_edges.empty() || !added_edges.empty()) {
+        UpdateRouter(removed_edges, added_edges);
+    }
+}
+
+void TransportRouter::UpdateRouter(const std::vector<graph::EdgeId>& removed_edges, const std::vector<graph::EdgeId>& added_edges) {
+    // Компоненты пересчитываются целиком: это линейно и дешевле любого обновления таблиц
+    components_ = graph::WeaklyConnectedComponents(graph_);
+    if (!pinned_trees_.empty()) {
+        std::vector<graph::VertexId> origins;
+        for (const auto& [origin, tree] : pinned_trees_) {
+            origins.push_back(origin);
+        }
+        BuildPinnedTrees(origins);
+    }
+
+    if (partitioned_router_) {
+        // Пересчитываются только ячейки, где лежат концы изменённых рёбер
+        std::vector<bool> is_changed(partitioned_router_->GetCellCount());
+        for (const auto& edge_ids : { std::cref(removed_edges), std::cref(added_edges) }) {
+            for (const auto edge_id : edge_ids.get()) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                is_changed[partitioned_router_->GetCellOf(edge.from)] = true;
+                is_changed[partitioned_router_->GetCellOf(edge.to)] = true;
+            }
+        }
+        for (size_t cell = 0; cell < is_changed.size(); ++cell) {
+            if (is_changed[cell]) {
+                partitioned_router_->RebuildCell(cell);
+            }
+        }
+        return;
+    }
+    // Без таблицы всех пар обновлять нечего: поиск на запрос сразу видит изменённый граф
+    if (!router_) {
+        return;
+    }
+    if (!removed_edges.empty()) {
+        router_->RebuildRoutesUsingEdges(removed_edges);
+    }
+    if (!added_edges.empty()) {
+        router_->RelaxEdges(added_edges);
+    }
+}
+
+bool TransportRouter::SuspendBus(std::string_view bus_name) {
+    return SetBusSuspended(bus_name, true);
+}
+
+bool TransportRouter::ResumeBus(std::string_view bus_name) {
+    return SetBusSuspended(bus_name, false);
+}
+
+bool TransportRouter::SuspendStop(std::string_view stop_name) {
+    return SetStopSuspended(stop_name, true);
+}
+
+bool TransportRouter::ResumeStop(std::string_view stop_name) {
+    return SetStopSuspended(stop_name, false);
+}
+
+void TransportRouter::ResumeAll() {
+    std::fill(suspended_buses_.begin(), suspended_buses_.end(), false);
+    std::fill(suspended_stops_.begin(), suspended_stops_.end(), false);
+    suspended_bus_count_ = 0;
+    suspended_stop_count_ = 0;
+}
+
+bool TransportRouter::SetBusSuspended(std::string_view bus_name, bool is_suspended) {
+    const auto it = bus_ids_.find(std::string(bus_name));
+    if (it == bus_ids_.end()) {
+        return false;
+    }
+    if (suspended_buses_[it->second] != is_suspended) {
+        suspended_buses_[it->second] = is_suspended;
+        is_suspended ? ++suspended_bus_count_ : --suspended_bus_count_;
+    }
+    return true;
+}
+
+bool TransportRouter::SetStopSuspended(std::string_view stop_name, bool is_suspended) {
+    const auto it = stop_ids_.find(stop_name);
+    if (it == stop_ids_.end()) {
+        return false;
+    }
+    const size_t stop_id = it->second / 2;
+    if (suspended_stops_[stop_id] != is_suspended) {
+        suspended_stops_[stop_id] = is_suspended;
+        is_suspended ? ++suspended_stop_count_ : --suspended_stop_count_;
+    }
+    return true;
+}
+
+std::vector<std::string_view> TransportRouter::GetSuspendedBuses() const {
+    std::vector<std::string_view> buses;
+    for (size_t bus_id = 0; bus_id < suspended_buses_.size(); ++bus_id) {
+        if (suspended_buses_[bus_id]) {
+            buses.push_back(bus_names_[bus_id]);
+        }
+    }
+    std::sort(buses.begin(), buses.end());
+    return buses;
+}
+
+std::vector<std::string_view> TransportRouter::GetSuspendedStops() const {
+    std::vector<std::string_view> stops;
+    for (size_t stop_id = 0; stop_id < suspended_stops_.size(); ++stop_id) {
+        if (suspended_stops_[stop_id]) {
+            stops.push_back(stop_names_[stop_id]);
+        }
+    }
+    std::sort(stops.begin(), stops.end());
+    return stops;
+}
+
+bool TransportRouter::IsEdgeAllowed(graph::EdgeId edge_id) const {
+    const auto& edge = graph_.GetEdge(edge_id);
+    const size_t bus_id = edge_bus_ids_[edge_id];
+    return (bus_id == NO_BUS || !suspended_buses_[bus_id])
+        && !suspended_stops_[edge.from / 2] && !suspended_stops_[edge.to / 2];
+}
+
+std::vector<StopReachability> TransportRouter::GetReachability() const {
+    const auto closure_start = std::chrono::steady_clock::now();
+    graph::TransitiveClosure::EdgeFilter is_edge_allowed;
+    if (HasDisruptions()) {
+        is_edge_allowed = [this](graph::EdgeId edge_id) { return IsEdgeAllowed(edge_id); };
+    }
+    const graph::TransitiveClosure closure(graph_, is_edge_allowed);
+    // Остановку представляет вершина прибытия; сама остановка из счёта исключается
+    const auto counts = closure.CountReachable([](graph::VertexId vertex) { return vertex % 2 == 0; });
+
+    std::vector<StopReachability> result;
+    result.reserve(stop_ids_.size());
+    for (const auto& [name, vertex] : stop_ids_) {
+        result.push_back({ name, counts.reachable[vertex] - 1, counts.reaching[vertex] - 1 });
+    }
+    const std::chrono::duration<double, std::milli> closure_time = std::chrono::steady_clock::now() - closure_start;
+    if (log_metrics_) {
+        LogReachabilityMetrics(closure, closure_time.count());
+    }
+    return result;
+}
+
+void TransportRouter::WarmUp(const std::vector<std::string_view>& stop_names) {
+    if (router_) {
+        return;
+    }
+    const auto warmup_start = std::chrono::steady_clock::now();
+    std::vector<graph::VertexId> origins;
+    for (const auto stop_name : stop_names) {
+        if (const auto it = stop_ids_.find(stop_name); it != stop_ids_.end() && !pinned_trees_.count(it->second)) {
+            origins.push_back(it->second);
+        }
+    }
+    std::sort(origins.begin(), origins.end());
+    origins.erase(std::unique(origins.begin(), origins.end()), origins.end());
+    BuildPinnedTrees(origins);
+
+    const std::chrono::duration<double, std::milli> warmup_time = std::chrono::steady_clock::now() - warmup_start;
+    if (log_metrics_) {
+        LogWarmUpMetrics(warmup_time.count());
+    }
+}
+
+void TransportRouter::BuildPinnedTrees(const std::vector<graph::VertexId>& origins) {
+    std::vector<PinnedTree> trees(origins.size());
+    const size_t worker_count = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(origins.size(), 1));
+    auto build_trees = [this, &origins, &trees, worker_count](size_t worker_index) {
+        graph::Dijkstra<RouteWeight> dijkstra(graph_);
+        for (size_t i = worker_index; i < origins.size(); i += worker_count) {
+            dijkstra.Run(origins[i]);
+            PinnedTree& tree = trees[i];
+            tree.weights.assign(graph_.GetVertexCount(), graph::UnreachableWeight<RouteWeight>());
+            tree.prev_edges.assign(graph_.GetVertexCount(), NO_EDGE);
+            for (const auto vertex : dijkstra.GetReachedVertices()) {
+                tree.weights[vertex] = dijkstra.GetWeight(vertex);
+                tree.prev_edges[vertex] = dijkstra.GetPrevEdge(vertex).value_or(NO_EDGE);
+            }
+        }
+    };
+    std::vector<std::future<void>> tasks;
+    for (size_t worker_index = 1; worker_index < worker_count; ++worker_index) {
+        tasks.push_back(std::async(std::launch::async, build_trees, worker_index));
+    }
+    build_trees(0);
+    for (auto& task : tasks) {
+        task.get();
+    }
+
+    for (size_t i = 0; i < origins.size(); ++i) {
+        pinned_trees_[origins[i]] = std::move(trees[i]);
+    }
+}
+
+std::optional<graph::ProfileId> TransportRouter::FindProfile(std::string_view profile_name) const {
+    for (graph::ProfileId profile = 1; profile < profiles_.size(); ++profile) {
+        if (profiles_[profile].name == profile_name) {
+            return profile;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<RouteResult> TransportRouter::FindRoute(std::string_view stop_from, std::string_view stop_to,
+    graph::ProfileId profile) const {
+    RouteResult result;
+    const auto total_time = ForEachRouteItem(stop_from, stop_to, [&result](const RouteItem& item) {
+        result.items.push_back(item);
+    }, profile);
+
+    if (!total_time) {
+        return std::nullopt;
+    }
+    result.total_time = *total_time;
+
+    return result;
 }
 
-std::optional<RouteResult> TransportRouter::FindRoute(std::string_view stop_from, std::string_view stop_to) const {
+std::vector<RouteResult> TransportRouter::FindRoutes(std::string_view stop_from, std::string_view stop_to, size_t k,
+    graph::ProfileId profile) const {
+    std::vector<RouteResult> results;
     auto from_it = stop_ids_.find(stop_from);
     auto to_it = stop_ids_.find(stop_to);
 
     if (from_it == stop_ids_.end() || to_it == stop_ids_.end()) {
-        return std::nullopt;
+        return results;
+    }
+    if (!components_.AreConnected(from_it->second, to_it->second)) {
+        return results;
     }
 
-    auto route_info = router_->BuildRoute(from_it->second, to_it->second);
+    auto& k_shortest_paths = k_shortest_paths_.at(profile);
+    if (!k_shortest_paths) {
+        // Одинаковые для пассажира рёбра (тот же автобус между теми же остановками)
+        // не должны давать разные альтернативы
+        k_shortest_paths = std::make_unique<graph::KShortestPaths<RouteWeight>>(graph_,
+            [this](graph::EdgeId lhs, graph::EdgeId rhs) {
+                const auto& lhs_edge = graph_.GetEdge(lhs);
+                const auto& rhs_edge = graph_.GetEdge(rhs);
+                return lhs_edge.from == rhs_edge.from && lhs_edge.to == rhs_edge.to
+                    && lhs_edge.quality == rhs_edge.quality && lhs_edge.name == rhs_edge.name;
+            }, std::thread::hardware_concurrency(), profile);
+    }
 
-    if (!route_info) {
-        return std::nullopt;
+    graph::KShortestPaths<RouteWeight>::EdgeFilter is_edge_allowed;
+    if (HasDisruptions()) {
+        is_edge_allowed = [this](graph::EdgeId edge_id) { return IsEdgeAllowed(edge_id); };
+    }
+    for (const auto& path : k_shortest_paths->Find(from_it->second, to_it->second, k, is_edge_allowed)) {
+        RouteResult result;
+        result.total_time = 0.0;
+        for (const auto edge_id : path.edges) {
+            result.items.push_back(MakeRouteItem(edge_id, profile));
+            result.total_time += result.items.back().time;
+        }
+        results.push_back(std::move(result));
     }
 
-    RouteResult result;
-    result.total_time = route_info->weight;
+    return results;
+}
 
-    for (const auto& edge_id : route_info->edges) {
-        const auto& edge = graph_.GetEdge(edge_id);
+std::optional<std::vector<ReachableStop>> TransportRouter::FindReachableStops(std::string_view stop_from, double max_time,
+    graph::ProfileId profile) const {
+    auto from_it = stop_ids_.find(stop_from);
+    if (from_it == stop_ids_.end()) {
+        return std::nullopt;
+    }
 
-        RouteItem item;
+    // Веса округлены по рёбрам, поэтому поиск идёт с запасом на накопленную ошибку,
+    // а граница проверяется по точному времени пути
+    auto& search = GetSearch(profile);
+    const RouteWeight max_weight = graph::AddWeights(ToRouteWeight(max_time), ISOCHRONE_WEIGHT_MARGIN);
+    if (HasDisruptions()) {
+        search.RunWithin(from_it->second, max_weight, [this](graph::EdgeId edge_id) { return IsEdgeAllowed(edge_id); });
+    }
+    else {
+        search.RunWithin(from_it->second, max_weight);
+    }
 
-        if (edge.quality == 0) 
-        { 
-            item.type = RouteItem::ItemType::Wait;
-            item.name = edge.name; 
-            item.time = edge.weight;
+    // Прибытие на остановку — её чётная вершина, нечётная означает «уже дождался автобуса»
+    std::vector<ReachableStop> stops;
+    for (const auto vertex : search.GetReachedVertices()) {
+        if (vertex % 2 != 0) {
+            continue;
         }
-        else 
-        {
-            item.type = RouteItem::ItemType::Bus;
-            item.name = edge.name; 
-            item.span_count = edge.quality;
-            item.time = edge.weight;
+        double time = 0.0;
+        search.ForEachPathEdge(vertex, [this, &time, profile](graph::EdgeId edge_id) {
+            time += GetEdgeTime(edge_id, profile);
+        });
+        if (vertex == from_it->second || !(max_time < time)) {
+            stops.push_back({ stop_names_[vertex / 2], time });
         }
-        result.items.push_back(std::move(item));
     }
+    std::sort(stops.begin(), stops.end(), [](const ReachableStop& lhs, const ReachableStop& rhs) {
+        return std::tie(lhs.time, lhs.name) < std::tie(rhs.time, rhs.name);
+    });
 
-    return result;
+    return stops;
 }
 
+RouteItem TransportRouter::MakeRouteItem(graph::EdgeId edge_id, graph::ProfileId profile) const {
+    const auto& edge = graph_.GetEdge(edge_id);
+    const double time = GetEdgeTime(edge_id, profile);
+    // Названия берутся не из рёбер: вектор рёбер графа перевыделяется при добавлении автобуса
+    if (edge.quality == 0)
+    {
+        return RouteItem{ RouteItem::ItemType::Wait, stop_names_[edge.from / 2], time, 0 };
+    }
+    return RouteItem{ RouteItem::ItemType::Bus, bus_names_[edge_bus_ids_[edge_id]], time, edge.quality };
+}
 
+RouteWeight TransportRouter::ToRouteWeight(double minutes) {
+    // Время не обрезается до предела: ребро с неверно малым весом дало бы неверный маршрут.
+    // NaN (скорость 0 при нулевом расстоянии) тоже непроходим
+    const double weight = std::round(minutes * ROUTE_WEIGHT_UNITS_PER_MINUTE);
+    if (!(weight < graph::UnreachableWeight<RouteWeight>())) {
+        return graph::UnreachableWeight<RouteWeight>();
+    }
+    return static_cast<RouteWeight>(weight);
+}
 
+double TransportRouter::GetTravelTime(double distance, const RoutingProfile& profile) {
+    return distance / (profile.bus_velocity * (1000.0 / 60.0));
+}
 
+double TransportRouter::GetEdgeTime(graph::EdgeId edge_id, graph::ProfileId profile) const {
+    const RoutingProfile& settings = profiles_[profile];
+    if (graph_.GetEdge(edge_id).quality == 0) {
+        return settings.bus_wait_time;
+    }
+    return GetTravelTime(edge_distances_[edge_id], settings);
+}
+
+graph::Dijkstra<RouteWeight>& TransportRouter::GetSearch(graph::ProfileId profile) const {
+    auto& search = searches_.at(profile);
+    if (!search) {
+        search = std::make_unique<graph::Dijkstra<RouteWeight>>(graph_, profile);
+    }
+    return *search;
+}
+
+graph::BidirectionalDijkstra<RouteWeight>& TransportRouter::GetRouteSearch(graph::ProfileId profile) const {
+    auto& search = route_searches_.at(profile);
+    if (!search) {
+        search = std::make_unique<graph::BidirectionalDijkstra<RouteWeight>>(graph_, profile);
+    }
+    return *search;
+}
+
+void TransportRouter::LogBuildMetrics(const RouterOptions& options, size_t table_bytes, double build_ms) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const size_t edge_count = graph_.GetEdgeCount();
+    // Каждое ребро есть в прямом и обратном списках инцидентности, каждый профиль кроме нулевого — столбец весов
+    const size_t graph_bytes = edge_count * (sizeof(graph::Edge<RouteWeight>) + 2 * sizeof(graph::EdgeId)
+        + (profiles_.size() - 1) * sizeof(RouteWeight))
+        + vertex_count * 2 * sizeof(std::vector<graph::EdgeId>);
+    // Двунаправленный поиск хранит состояние вершин для каждого из двух направлений
+    const size_t search_bytes = vertex_count * 2 * (sizeof(RouteWeight) + sizeof(std::optional<graph::EdgeId>) + sizeof(size_t));
+    // Оценка пика по размерам структур, а не замер: граф плюс таблица всех пар, либо граф
+    // плюс таблицы ячеек, либо граф плюс состояние поиска по вершинам
+    size_t peak_bytes_estimate = graph_bytes + search_bytes;
+    if (router_) {
+        peak_bytes_estimate = graph_bytes + table_bytes;
+    }
+    else if (partitioned_router_) {
+        peak_bytes_estimate = graph_bytes + partitioned_router_->GetMemoryUsage();
+    }
 
+    const char* backend_name = "on_demand";
+    if (backend_ == RouterBackend::AllPairs) {
+        backend_name = "all_pairs";
+    }
+    else if (backend_ == RouterBackend::Partitioned) {
+        backend_name = "partitioned";
+    }
+
+    std::cerr << "{\"event\": \"router_build\""
+        << ", \"backend\": \"" << backend_name << "\""
+        << ", \"vertex_count\": " << vertex_count
+        << ", \"edge_count\": " << edge_count
+        << ", \"component_count\": " << components_.GetComponentCount()
+        << ", \"profile_count\": " << profiles_.size()
+        << ", \"table_bytes_estimate\": " << table_bytes
+        << ", \"memory_budget\": " << options.memory_budget
+        << ", \"peak_bytes_estimate\": " << peak_bytes_estimate
+        << ", \"build_ms\": " << build_ms;
+    if (partitioned_router_) {
+        std::cerr << ", \"cell_count\": " << partitioned_router_->GetCellCount()
+            << ", \"boundary_vertex_count\": " << partitioned_router_->GetBoundaryVertexCount();
+    }
+    if (boundary_share_) {
+        std::cerr << ", \"boundary_vertex_share\": " << *boundary_share_;
+    }
+    std::cerr << "}" << std::endl;
+}
+
+void TransportRouter::LogWarmUpMetrics(double warmup_ms) const {
+    const size_t tree_bytes = graph_.GetVertexCount() * (sizeof(RouteWeight) + sizeof(graph::EdgeId));
+    std::cerr << "{\"event\": \"router_warmup\""
+        << ", \"origin_count\": " << pinned_trees_.size()
+        << ", \"pinned_bytes\": " << pinned_trees_.size() * tree_bytes
+        << ", \"warmup_ms\": " << warmup_ms
+        << "}" << std::endl;
+}
+
+void TransportRouter::LogReachabilityMetrics(const graph::TransitiveClosure& closure, double closure_ms) const {
+    const size_t component_count = closure.GetComponentCount();
+    std::cerr << "{\"event\": \"router_reachability\""
+        << ", \"component_count\": " << component_count
+        << ", \"level_count\": " << closure.GetLevelCount()
+        << ", \"closure_bytes\": " << component_count * ((component_count + 63) / 64) * sizeof(std::uint64_t)
+        << ", \"closure_ms\": " << closure_ms
+        << "}" << std::endl;
+}
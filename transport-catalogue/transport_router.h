@@ -1,11 +1,21 @@
 #pragma once
 
+#include "bidirectional_dijkstra.h"
+#include "components.h"
+#include "k_shortest_paths.h"
+#include "partitioned_router.h"
 #include "router.h"
+#include "transitive_closure.h"
 #include "transport_catalogue.h"
+#include <algorithm>
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <string>
 #include <string_view>
 #include <optional>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 struct RouteItem
@@ -16,7 +26,9 @@ struct RouteItem
         Bus
     };
     ItemType type;
-    std::string name;
+    // Название остановки из каталога или автобуса из словаря номеров автобусов роутера.
+    // Оба не перемещаются при изменении графа и живут, пока жив роутер
+    std::string_view name;
     double time;
     size_t span_count;
 };
@@ -26,25 +38,285 @@ struct RouteResult {
     std::vector<RouteItem> items;
 };
 
+struct ReachableStop {
+    std::string_view name;
+    double time;
+};
+
+struct StopReachability {
+    std::string_view name;
+    // Сколько других остановок достижимо от этой и от скольких достижима она
+    size_t reachable_stop_count;
+    size_t reaching_stop_count;
+};
+
+// Таблица кратчайших путей между всеми парами даёт ответ за O(длины маршрута), но требует
+// V^2 памяти; поиск Дейкстры на каждый запрос медленнее, зато почти не требует памяти.
+// Разбиение на ячейки — середина: таблицы только внутри ячеек, между ними поиск по границам
+enum class RouterBackend
+{
+    Auto,
+    AllPairs,
+    OnDemand,
+    Partitioned
+};
+
+// Период движения со своими скоростью автобусов и временем ожидания
+struct RoutingProfile
+{
+    std::string name;
+    int bus_wait_time = 0;
+    double bus_velocity = 0.0;
+};
+
+struct RouterOptions
+{
+    RouterBackend backend = RouterBackend::Auto;
+    // Auto выбирает таблицу, только если её оценка укладывается в этот предел
+    size_t memory_budget = size_t{ 1024 } * 1024 * 1024;
+    // Для Partitioned: сколько соседних по координатам остановок попадает в одну ячейку
+    size_t cell_size = 256;
+    // Для Partitioned: если граничных вершин больше этой доли, разбиение вырождается
+    // и вместо него выбирается OnDemand
+    double max_boundary_share = 0.5;
+    // Дополнительные профили получают номера 1, 2, ... в порядке списка; профиль 0 задают
+    // bus_wait_time и bus_velocity конструктора роутера
+    std::vector<RoutingProfile> profiles;
+    // Метрики сборки, прогрева и достижимости пишутся в std::cerr строками JSON
+    bool log_metrics = false;
+};
+
+// Время в графе роутера — целое число сотых долей секунды. Целые сложения и сравнения
+// дешевле и векторизуются, а ячейка таблицы маршрутов вдвое меньше, чем с double.
+// Вес служит только для выбора маршрута: время в ответах считается в double по длинам
+// перегонов, поэтому округление сказывается лишь на выборе между маршрутами, равными
+// с точностью до сотой секунды. Предел — UnreachableWeight, около 2980 часов: ребро
+// тяжелее предела непроходимо, а путь длиннее предела не находится
+using RouteWeight = std::int32_t;
+
 class TransportRouter {
 public:
-    TransportRouter(const TransportCatalogue& catalogue, int bus_wait_time = 0, double bus_velocity = 0.0);
-    std::optional<RouteResult> FindRoute(std::string_view stop_from, std::string_view stop_to) const;
+    TransportRouter(const TransportCatalogue& catalogue, int bus_wait_time = 0, double bus_velocity = 0.0,
+        RouterOptions options = {});
+
+    RouterBackend GetBackend() const { return backend_; }
+
+    // Все профили делят один граф: у рёбер по столбцу весов на профиль.
+    // Таблицы, ячейки и прогрев строятся для профиля 0, остальные профили
+    // отвечают двунаправленным поиском по своим весам
+    std::optional<graph::ProfileId> FindProfile(std::string_view profile_name) const;
+    size_t GetProfileCount() const { return profiles_.size(); }
+
+    std::optional<RouteResult> FindRoute(std::string_view stop_from, std::string_view stop_to, graph::ProfileId profile = 0) const;
+
+    // Отдаёт элементы маршрута посетителю по мере обхода, без промежуточных контейнеров.
+    // Возвращает общее время или nullopt, если маршрута нет
+    template <typename ItemVisitor>
+    std::optional<double> ForEachRouteItem(std::string_view stop_from, std::string_view stop_to, ItemVisitor&& visitor,
+        graph::ProfileId profile = 0) const;
+
+    // До k маршрутов без повторных остановок в порядке возрастания времени
+    std::vector<RouteResult> FindRoutes(std::string_view stop_from, std::string_view stop_to, size_t k,
+        graph::ProfileId profile = 0) const;
+
+    // Все остановки, до которых можно доехать не дольше max_time, по возрастанию времени.
+    // nullopt, если исходной остановки нет
+    std::optional<std::vector<ReachableStop>> FindReachableStops(std::string_view stop_from, double max_time,
+        graph::ProfileId profile = 0) const;
+
+    // Достижимость для всех остановок сразу, в порядке названий. Считается по транзитивному
+    // замыканию графа с учётом перерывов в движении, без поиска маршрутов
+    std::vector<StopReachability> GetReachability() const;
+
+    // Инкрементальное обновление после изменения каталога (каталог уже изменён).
+    // Рёбра перечисленных автобусов и автобусов, проходящих по изменённым перегонам, строятся
+    // заново по каталогу (автобуса в каталоге нет — рёбра удаляются), а таблица маршрутов
+    // пересчитывается один раз на весь набор и только в затронутых ячейках.
+    // Новые остановки так не добавить: для них нужен новый роутер
+    void Update(const std::vector<std::string_view>& bus_names,
+        const std::vector<std::pair<std::string_view, std::string_view>>& distances = {});
+    void AddBus(std::string_view bus_name) { Update({ bus_name }); }
+    void RemoveBus(std::string_view bus_name) { Update({ bus_name }); }
+    void UpdateDistance(std::string_view stop_from, std::string_view stop_to) { Update({}, { { stop_from, stop_to } }); }
+
+    // Перерывы в движении: приостановленные автобусы и закрытые остановки маршруты обходят
+    // без перестройки роутера. Через закрытую остановку автобус проезжает, но сесть
+    // или выйти на ней нельзя. false, если автобуса или остановки нет
+    bool SuspendBus(std::string_view bus_name);
+    bool ResumeBus(std::string_view bus_name);
+    bool SuspendStop(std::string_view stop_name);
+    bool ResumeStop(std::string_view stop_name);
+    void ResumeAll();
+    bool HasBus(std::string_view bus_name) const { return bus_ids_.count(std::string(bus_name)) > 0; }
+    bool HasStop(std::string_view stop_name) const { return stop_ids_.count(stop_name) > 0; }
+    bool HasDisruptions() const { return suspended_bus_count_ + suspended_stop_count_ > 0; }
+    std::vector<std::string_view> GetSuspendedBuses() const;
+    std::vector<std::string_view> GetSuspendedStops() const;
+
+    // Прогрев: для частых начальных остановок деревья кратчайших путей строятся заранее
+    // (параллельно) и закрепляются, так что первые запросы от них не ждут поиска.
+    // С таблицей всех пар прогревать нечего. Неизвестные остановки пропускаются
+    void WarmUp(const std::vector<std::string_view>& stop_names);
+    size_t GetWarmOriginCount() const { return pinned_trees_.size(); }
 
 private:
+    // Закреплённое дерево кратчайших путей от одной вершины
+    struct PinnedTree {
+        std::vector<RouteWeight> weights;
+        std::vector<graph::EdgeId> prev_edges;
+    };
+    static constexpr graph::EdgeId NO_EDGE = static_cast<graph::EdgeId>(-1);
+
+    void BuildPinnedTrees(const std::vector<graph::VertexId>& origins);
     void InitializeStops();
+    std::vector<graph::PartitionedRouter<RouteWeight>::CellId> SplitIntoCells(size_t cell_size) const;
     void AddBusEdges();
+    std::vector<graph::EdgeId> AddBusEdges(const Bus& bus);
+    // Ребро поездки на distance метров с весами всех профилей
+    graph::EdgeId AddTravelEdge(const std::string& bus_name, size_t span_count, graph::VertexId from, graph::VertexId to,
+        double distance);
+    std::vector<graph::EdgeId> RemoveBusEdges(std::string_view bus_name);
+    void UpdateRouter(const std::vector<graph::EdgeId>& removed_edges, const std::vector<graph::EdgeId>& added_edges);
+    RouteItem MakeRouteItem(graph::EdgeId edge_id, graph::ProfileId profile) const;
+    // Маршрут выбранным способом, без учёта перерывов в движении
+    template <typename EdgeVisitor>
+    std::optional<RouteWeight> ForEachRouteEdge(graph::VertexId from, graph::VertexId to, EdgeVisitor&& visitor,
+        graph::ProfileId profile) const;
+    size_t GetBusId(const std::string& bus_name);
+    bool SetBusSuspended(std::string_view bus_name, bool is_suspended);
+    bool SetStopSuspended(std::string_view stop_name, bool is_suspended);
+    bool IsEdgeAllowed(graph::EdgeId edge_id) const;
+    graph::Dijkstra<RouteWeight>& GetSearch(graph::ProfileId profile) const;
+    graph::BidirectionalDijkstra<RouteWeight>& GetRouteSearch(graph::ProfileId profile) const;
+    // Перевод минут в вес графа; время, не помещающееся в RouteWeight, становится UnreachableWeight
+    static RouteWeight ToRouteWeight(double minutes);
+    static double GetTravelTime(double distance, const RoutingProfile& profile);
+    // Точное время прохода по ребру в минутах, без округления веса
+    double GetEdgeTime(graph::EdgeId edge_id, graph::ProfileId profile) const;
+    void LogBuildMetrics(const RouterOptions& options, size_t table_bytes, double build_ms) const;
+    void LogWarmUpMetrics(double warmup_ms) const;
+    void LogReachabilityMetrics(const graph::TransitiveClosure& closure, double closure_ms) const;
 
-    const TransportCatalogue catalogue_;
-    int bus_wait_time_;
-    double bus_velocity_;
+    const TransportCatalogue& catalogue_;
+    // profiles_[0] — профиль из параметров конструктора
+    std::vector<RoutingProfile> profiles_;
 
-    graph::DirectedWeightedGraph<double> graph_;
+    graph::DirectedWeightedGraph<RouteWeight> graph_;
     std::map<std::string_view, graph::VertexId> stop_ids_;
-    std::unique_ptr<graph::Router<double>> router_;
+    std::vector<std::string_view> stop_names_;
+    std::unordered_map<std::string, std::vector<graph::EdgeId>> bus_edges_;
+    // Отсекает запросы между несвязанными частями сети до любого поиска
+    graph::WeaklyConnectedComponents components_;
+
+    // Маски перерывов в движении: по номеру автобуса и по номеру остановки (вершина / 2)
+    static constexpr size_t NO_BUS = static_cast<size_t>(-1);
+    std::unordered_map<std::string, size_t> bus_ids_;
+    // Указывают на ключи bus_ids_: узлы словаря не перемещаются, и номер автобуса
+    // не освобождается, даже если автобус удалён
+    std::vector<std::string_view> bus_names_;
+    // Номер автобуса для каждого ребра, NO_BUS у рёбер ожидания
+    std::vector<size_t> edge_bus_ids_;
+    // Длина перегона в метрах для каждого ребра, 0 у рёбер ожидания
+    std::vector<double> edge_distances_;
+    std::vector<bool> suspended_buses_;
+    std::vector<bool> suspended_stops_;
+    size_t suspended_bus_count_ = 0;
+    size_t suspended_stop_count_ = 0;
+    RouterBackend backend_;
+    bool log_metrics_;
+    // Есть только при RouterBackend::AllPairs
+    std::unique_ptr<graph::Router<RouteWeight>> router_;
+    // Есть только при RouterBackend::Partitioned
+    std::unique_ptr<graph::PartitionedRouter<RouteWeight>> partitioned_router_;
+    // Доля граничных вершин разбиения, если Partitioned был запрошен
+    std::optional<double> boundary_share_;
+    // Поиски по профилям создаются при первом обращении и переиспользуют состояние между запросами:
+    // альтернативы, изохроны и маршруты без таблицы
+    mutable std::vector<std::unique_ptr<graph::KShortestPaths<RouteWeight>>> k_shortest_paths_;
+    mutable std::vector<std::unique_ptr<graph::Dijkstra<RouteWeight>>> searches_;
+    mutable std::vector<std::unique_ptr<graph::BidirectionalDijkstra<RouteWeight>>> route_searches_;
+    std::unordered_map<graph::VertexId, PinnedTree> pinned_trees_;
+    // Рёбра маршрута, который нужно проверить на перерывы в движении; переиспользуется между запросами
+    mutable std::vector<graph::EdgeId> route_edges_;
 };
 
+template <typename EdgeVisitor>
+std::optional<RouteWeight> TransportRouter::ForEachRouteEdge(graph::VertexId from, graph::VertexId to, EdgeVisitor&& visitor,
+    graph::ProfileId profile) const {
+    if (profile != 0) {
+        return GetRouteSearch(profile).ForEachRouteEdge(from, to, visitor);
+    }
+    if (router_) {
+        return router_->ForEachRouteEdge(from, to, visitor);
+    }
+    if (const auto it = pinned_trees_.find(from); it != pinned_trees_.end()) {
+        const PinnedTree& tree = it->second;
+        if (!(tree.weights[to] < graph::UnreachableWeight<RouteWeight>())) {
+            return std::nullopt;
+        }
+        auto get_prev_edge = [&tree](graph::EdgeId edge_id) -> std::optional<graph::EdgeId> {
+            return edge_id != NO_EDGE ? std::optional(edge_id) : std::nullopt;
+        };
+        graph::VisitEdgeChain(get_prev_edge(tree.prev_edges[to]), [this, &tree, &get_prev_edge](graph::EdgeId edge_id) {
+            return get_prev_edge(tree.prev_edges[graph_.GetEdge(edge_id).from]);
+        }, visitor);
+        return tree.weights[to];
+    }
+    if (partitioned_router_) {
+        return partitioned_router_->ForEachRouteEdge(from, to, visitor);
+    }
+    return GetRouteSearch(profile).ForEachRouteEdge(from, to, visitor);
+}
 
+template <typename ItemVisitor>
+std::optional<double> TransportRouter::ForEachRouteItem(std::string_view stop_from, std::string_view stop_to, ItemVisitor&& visitor,
+    graph::ProfileId profile) const {
+    auto from_it = stop_ids_.find(stop_from);
+    auto to_it = stop_ids_.find(stop_to);
 
+    if (from_it == stop_ids_.end() || to_it == stop_ids_.end()) {
+        return std::nullopt;
+    }
+    if (!components_.AreConnected(from_it->second, to_it->second)) {
+        return std::nullopt;
+    }
 
+    double total_time = 0.0;
+    auto visit_edge = [this, &visitor, &total_time, profile](graph::EdgeId edge_id) {
+        const RouteItem item = MakeRouteItem(edge_id, profile);
+        total_time += item.time;
+        visitor(item);
+    };
+    if (!HasDisruptions()) {
+        if (!ForEachRouteEdge(from_it->second, to_it->second, visit_edge, profile)) {
+            return std::nullopt;
+        }
+        return total_time;
+    }
 
+    // Готовый маршрут годится, если не задевает приостановленных автобусов и остановок,
+    // иначе он ищется заново в обход них
+    auto& edges = route_edges_;
+    edges.clear();
+    auto collect_edge = [&edges](graph::EdgeId edge_id) {
+        edges.push_back(edge_id);
+    };
+    auto weight = ForEachRouteEdge(from_it->second, to_it->second, collect_edge, profile);
+    if (weight && !std::all_of(edges.begin(), edges.end(), [this](graph::EdgeId edge_id) { return IsEdgeAllowed(edge_id); })) {
+        auto& search = GetSearch(profile);
+        search.Run(from_it->second, to_it->second, [this](graph::EdgeId edge_id) { return IsEdgeAllowed(edge_id); });
+        weight.reset();
+        edges.clear();
+        if (search.IsReached(to_it->second)) {
+            weight = search.GetWeight(to_it->second);
+            search.ForEachPathEdge(to_it->second, collect_edge);
+        }
+    }
+    if (!weight) {
+        return std::nullopt;
+    }
+    for (const auto edge_id : edges) {
+        visit_edge(edge_id);
+    }
+    return total_time;
+}